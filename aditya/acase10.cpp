@@ -37,7 +37,10 @@ struct Vehicle {
     double fuelPerKm; // liters per km
     vector<int> route; // sequence of node ids (depot,...deliveries,...depot)
     double loadAssigned; // current assigned load
+    double peakLoad;     // most carried at once along the route
     vector<int> assignedShipments; // shipment ids
+    vector<int> routeShipments;    // shipment id picked up or delivered at each route stop (-1 at the depot)
+    double maxRouteKm;             // shift length limit, 0 = none
 };
 
 /* -------------------------
@@ -72,7 +75,8 @@ vector<double> dijkstra(const Graph &g, int src) {
     return dist;
 }
 
-// All-pairs shortest distances for small graphs (we compute on demand per depot)
+// All-pairs shortest distances for small graphs, one row at a time on one thread.
+// Kept as the benchmark baseline for DistanceMatrix.
 vector<vector<double>> allPairsShortest(const Graph &g) {
     int n = g.size();
     vector<vector<double>> ap(n, vector<double>(n, 1e18));
@@ -82,12 +86,191 @@ vector<vector<double>> allPairsShortest(const Graph &g) {
     return ap;
 }
 
+// Reusable buffers for repeated single-source searches (one per worker thread)
+struct DijkstraWorkspace {
+    vector<double> dist;
+    vector<pair<double,int>> heap;
+};
+
+// Dijkstra from src into row[0..n) as float32 kilometres
+void shortestRowInto(const Graph &g, int src, float *row, DijkstraWorkspace &ws) {
+    int n = g.size();
+    const double INF = 1e18;
+    ws.dist.assign(n, INF);
+    ws.heap.clear();
+    auto later = [](const pair<double,int> &a, const pair<double,int> &b) { return a.first > b.first; };
+    ws.dist[src] = 0;
+    ws.heap.push_back({0, src});
+    while (!ws.heap.empty()) {
+        pop_heap(ws.heap.begin(), ws.heap.end(), later);
+        auto [d,u] = ws.heap.back(); ws.heap.pop_back();
+        if (d > ws.dist[u]) continue;
+        for (auto &e : g[u]) {
+            if (ws.dist[e.to] > d + e.dist) {
+                ws.dist[e.to] = d + e.dist;
+                ws.heap.push_back({ws.dist[e.to], e.to});
+                push_heap(ws.heap.begin(), ws.heap.end(), later);
+            }
+        }
+    }
+    for (int v = 0; v < n; ++v) row[v] = (float)ws.dist[v];
+}
+
+/* -------------------------
+   Distance matrix: flat, parallel, lazy rows
+   ------------------------- */
+
+// Shortest-path distances in one flat float32 block (4 bytes per entry, rows contiguous).
+// Dense mode computes every row up front, one Dijkstra per source spread over threads.
+// Lazy mode keeps only a fixed number of rows (depots, pickups, deliveries in practice)
+// in an LRU cache and computes a missing row on first use. distMat[u][v] reads the same
+// way in both modes, so the routing code does not care which one it gets.
+// Dense lookups are safe from any number of threads; lazy lookups update the LRU and
+// belong to one thread at a time.
+class DistanceMatrix {
+    const Graph *graph = nullptr;
+    int n = 0;
+    bool lazy = false;
+    mutable vector<float> cells;           // dense: n*n; lazy: capacity rows of n
+    mutable vector<int> slotOf;            // lazy: node -> cache slot, -1 if absent
+    mutable vector<int> nodeInSlot;
+    mutable vector<unsigned long long> lastUse;
+    mutable unsigned long long tick = 0;
+    mutable size_t misses = 0;
+    mutable DijkstraWorkspace ws;
+
+    static int threadCount(int threads, int jobs) {
+        if (threads <= 0) threads = max(1u, thread::hardware_concurrency());
+        return max(1, min(threads, jobs));
+    }
+    // Computes row sources[i] into rows[i] for all i, sources pulled from a shared counter
+    void computeRows(const vector<int> &sources, const vector<float*> &rows, int threads) const {
+        atomic<int> next(0);
+        auto work = [&]() {
+            DijkstraWorkspace local;
+            for (int i; (i = next.fetch_add(1)) < (int)sources.size(); )
+                shortestRowInto(*graph, sources[i], rows[i], local);
+        };
+        threads = threadCount(threads, sources.size());
+        if (threads == 1) { work(); return; }
+        vector<thread> pool;
+        for (int t = 0; t < threads; ++t) pool.emplace_back(work);
+        for (auto &th : pool) th.join();
+    }
+    // A free slot, else the least recently used one not touched after tick `since`;
+    // -1 if every slot was used since then
+    int victimSlot(unsigned long long since) const {
+        int best = -1;
+        for (int s = 0; s < (int)nodeInSlot.size(); ++s) {
+            if (nodeInSlot[s] < 0) return s;
+            if (lastUse[s] <= since && (best < 0 || lastUse[s] < lastUse[best])) best = s;
+        }
+        return best;
+    }
+    int claimSlot(int node, unsigned long long since) const {
+        int s = victimSlot(since);
+        if (s < 0) return -1;
+        if (nodeInSlot[s] >= 0) slotOf[nodeInSlot[s]] = -1;
+        nodeInSlot[s] = node;
+        slotOf[node] = s;
+        lastUse[s] = ++tick;
+        return s;
+    }
+    const float *lazyRow(int u) const {
+        int s = slotOf[u];
+        if (s < 0) {
+            s = claimSlot(u, tick);
+            shortestRowInto(*graph, u, &cells[(size_t)s * n], ws);
+            misses++;
+        } else lastUse[s] = ++tick;
+        return &cells[(size_t)s * n];
+    }
+
+public:
+    // Lazy rows are looked up at the second subscript, so a row evicted while another
+    // operand is evaluated is never read through a stale pointer
+    struct RowRef {
+        const DistanceMatrix *m;
+        const float *row;   // dense mode
+        int u;
+        double operator[](int v) const { return row ? row[v] : m->lazyRow(u)[v]; }
+    };
+
+    void buildDense(const Graph &g, int threads = 0) {
+        graph = &g;
+        n = g.size();
+        lazy = false;
+        cells.assign((size_t)n * n, 0.0f);
+        vector<int> sources(n);
+        vector<float*> rows(n);
+        for (int i = 0; i < n; ++i) { sources[i] = i; rows[i] = &cells[(size_t)i * n]; }
+        computeRows(sources, rows, threads);
+    }
+
+    // Only cacheRows rows are ever held; the graph must outlive the matrix
+    void buildLazy(const Graph &g, int cacheRows) {
+        graph = &g;
+        n = g.size();
+        lazy = true;
+        cacheRows = max(1, min(cacheRows, n));
+        cells.assign((size_t)cacheRows * n, 0.0f);
+        slotOf.assign(n, -1);
+        nodeInSlot.assign(cacheRows, -1);
+        lastUse.assign(cacheRows, 0);
+        tick = misses = 0;
+    }
+
+    // Lazy mode: computes the missing rows among sources in parallel, so routing over
+    // those nodes never stalls on a search. A slot used earlier in the same call is never
+    // evicted (rows must stay distinct for the workers); once none is left it stops.
+    void prefetch(const vector<int> &sources, int threads = 0) {
+        if (!lazy) return;
+        unsigned long long start = tick;
+        vector<int> todo;
+        vector<float*> rows;
+        for (int u : sources) {
+            if (slotOf[u] >= 0) { lastUse[slotOf[u]] = ++tick; continue; }
+            int s = claimSlot(u, start);
+            if (s < 0) break;
+            todo.push_back(u);
+            rows.push_back(&cells[(size_t)s * n]);
+        }
+        computeRows(todo, rows, threads);
+        misses += todo.size();
+    }
+
+    RowRef operator[](int u) const { return {this, lazy ? nullptr : &cells[(size_t)u * n], u}; }
+    double at(int u, int v) const { return (*this)[u][v]; }
+
+    int size() const { return n; }
+    bool isLazy() const { return lazy; }
+    size_t rowsComputed() const { return lazy ? misses : n; }
+    size_t memoryBytes() const { return cells.capacity() * sizeof(float); }
+};
+
+// Dense when the full matrix is small, otherwise lazy rows for the nodes routing visits
+const size_t DENSE_MATRIX_LIMIT_BYTES = 256u << 20;
+
+void buildDistanceMatrix(DistanceMatrix &distMat, const Graph &g,
+                         const vector<Shipment> &shipments, const vector<Vehicle> &vehicles)
+{
+    size_t n = g.size();
+    if (n * n * sizeof(float) <= DENSE_MATRIX_LIMIT_BYTES) { distMat.buildDense(g); return; }
+    vector<int> hot;
+    for (auto &v : vehicles) hot.push_back(v.depot);
+    for (auto &s : shipments) { hot.push_back(s.pickup); hot.push_back(s.delivery); }
+    sort(hot.begin(), hot.end());
+    hot.erase(unique(hot.begin(), hot.end()), hot.end());
+    distMat.buildLazy(g, (int)hot.size());
+    distMat.prefetch(hot);
+}
+
 /* -------------------------
    Route utilities
    ------------------------- */
 
 // Compute route distance given a sequence of nodes and precomputed matrix dist
-double routeDistance(const vector<int> &route, const vector<vector<double>> &distMat) {
+double routeDistance(const vector<int> &route, const DistanceMatrix &distMat) {
     double total = 0.0;
     for (size_t i = 1; i < route.size(); ++i) {
         total += distMat[route[i-1]][route[i]];
@@ -96,7 +279,7 @@ double routeDistance(const vector<int> &route, const vector<vector<double>> &dis
 }
 
 // 2-opt improvement for route (exclude first and last if depot duplicated)
-bool twoOptImprove(vector<int> &route, const vector<vector<double>> &distMat) {
+bool twoOptImprove(vector<int> &route, const DistanceMatrix &distMat) {
     bool improved = false;
     int n = route.size();
     if (n <= 3) return false;
@@ -121,57 +304,496 @@ bool twoOptImprove(vector<int> &route, const vector<vector<double>> &distMat) {
     return improved;
 }
 
-// Improve until no improvement or limit
-void twoOptLoop(vector<int> &route, const vector<vector<double>> &distMat, int iterLimit=100) {
+// Improve until no improvement or limit. Each pass is O(n^2) for one move; kept as the
+// benchmark baseline for RouteLocalSearch.
+void twoOptLoop(vector<int> &route, const DistanceMatrix &distMat, int iterLimit=100) {
     int it = 0;
     while (it++ < iterLimit && twoOptImprove(route, distMat)) {}
 }
 
+/* -------------------------
+   Neighbor-list local search (2-opt, Or-opt)
+   ------------------------- */
+
+// A depot-to-depot route is treated as a cycle of stops (the closing depot is dropped and
+// re-added at the end). Each stop only tries moves towards its k nearest stops, with
+// don't-look bits: a stop is re-examined only after one of its tour edges changed.
+// Moves are applied first-improvement. A 2-opt reverses whichever side of the cycle is
+// shorter, and Or-opt (segments of 1..3 stops, relocate included) is built from two or
+// three such reversals. Distances are assumed symmetric (undirected network). The plain
+// optimize() leaves the visit order free; the pickup/delivery overload undoes any move
+// after which a delivery comes before its pickup or the load exceeds capacity, replaying
+// its reversals backwards. Read from the depot in the feasible direction, a move only
+// reverses stretches of the route, so only the stops in them are checked.
+struct LocalSearchOptions {
+    int neighbors = 10;
+    int maxSegment = 3;   // 0 disables Or-opt
+};
+
+class RouteLocalSearch {
+public:
+    struct Stats {
+        long long twoOptMoves = 0, orOptMoves = 0;
+    };
+
+private:
+    const DistanceMatrix &distMat;
+    LocalSearchOptions opt;
+    vector<int> node;               // stop -> network node
+    vector<int> tour, pos;          // tour[i] = stop at position i, pos = inverse
+    vector<vector<int>> nbr;        // stop -> nearest other stops, closest first
+    vector<char> queued;
+    deque<int> work;
+    int m = 0;
+    // Pickup/delivery checks (constrained optimize only)
+    bool constrained = false;
+    vector<int> mate;               // stop -> other stop of its shipment, -1 for none
+    vector<char> isPickup;
+    vector<double> change;          // load change at the stop
+    double capacity = 0;
+    vector<double> loadAfter;       // stop -> load on leaving it, in the feasible reading
+    bool dir = true;                // the feasible reading walks the tour forward
+    int touchedLo = 0, touchedHi = 0;       // reading positions reversed by the current move
+    vector<pair<int,int>> applied;          // (start, length) of its reversals, to undo them
+    vector<int> order;
+    static constexpr double EPS = 1e-7;
+
+    double d(int a, int b) const { return distMat[node[a]][node[b]]; }
+    int succ(int s) const { return tour[pos[s] + 1 == m ? 0 : pos[s] + 1]; }
+    int pred(int s) const { return tour[pos[s] == 0 ? m - 1 : pos[s] - 1]; }
+    int step(int s, bool forward) const { return forward ? succ(s) : pred(s); }
+
+    void push(int s) { if (!queued[s]) { queued[s] = 1; work.push_back(s); } }
+
+    // Position of stop s in the feasible reading from the depot, and the stop at position k
+    int readingIndex(int s) const { return dir ? (pos[s] - pos[0] + m) % m : (pos[0] - pos[s] + m) % m; }
+    int readingAt(int k) const { return tour[dir ? (pos[0] + k) % m : (pos[0] - k + m) % m]; }
+
+    // Pickup-before-delivery and capacity over the reversed reading positions; stops
+    // before and after them keep their order and loads, and a pickup outside the range
+    // still comes before it
+    bool touchedFeasible() const {
+        double load = loadAfter[readingAt(touchedLo - 1)];
+        for (int k = touchedLo; k <= touchedHi; ++k) {
+            int s = readingAt(k);
+            if (!isPickup[s] && mate[s] >= 0 && readingIndex(mate[s]) > k) return false;
+            load += change[s];
+            if (load > capacity + 1e-9) return false;
+        }
+        return true;
+    }
+    // Reading gap of tour edge {x,y}: g sits between reading positions g-1 and g, m is
+    // the edge back into the depot
+    int gapOf(int x, int y) const {
+        int ix = readingIndex(x), iy = readingIndex(y);
+        if (min(ix, iy) == 0 && max(ix, iy) == m - 1) return m;
+        return max(ix, iy);
+    }
+    // Same checks as touchedFeasible() on a reading positions lo..hi would get, given as
+    // the old position now at k and the new position of old position y, before any move
+    template <typename OldAt, typename NewPos>
+    bool readingFits(int lo, int hi, OldAt oldAt, NewPos newPos) const {
+        double load = loadAfter[readingAt(lo - 1)];
+        for (int k = lo; k <= hi; ++k) {
+            int s = readingAt(oldAt(k));
+            if (!isPickup[s] && mate[s] >= 0) {
+                int y = readingIndex(mate[s]);
+                if (y >= lo && y <= hi && newPos(y) > k) return false;
+            }
+            load += change[s];
+            if (load > capacity + 1e-9) return false;
+        }
+        return true;
+    }
+    // A 2-opt reverses the reading between its two edges
+    bool twoOptFits(int a, int b, int c, int dd) const {
+        int lo = gapOf(a, b), hi = gapOf(c, dd);
+        if (lo > hi) swap(lo, hi);
+        --hi;
+        auto mirror = [&](int k) { return lo + hi - k; };
+        return readingFits(lo, hi, mirror, mirror);
+    }
+    // An Or-opt takes reading positions of the segment a..sL out and puts them into the
+    // gap between c and e, a next to c. A segment through the depot is left to the exact
+    // check.
+    bool orOptFits(int a, int sL, int len, int c, int e) const {
+        int ia = readingIndex(a), iL = readingIndex(sL), sd = ia <= iL ? 1 : -1;
+        int x1 = min(ia, iL), x2 = max(ia, iL), g = gapOf(c, e);
+        if (x1 == 0 || x2 - x1 != len - 1) return true;
+        bool aFirst = readingAt(g - 1) == c;
+        auto segOld = [&](int t) { return aFirst ? ia + t * sd : iL - t * sd; };
+        auto segNew = [&](int y) { return aFirst ? (y - ia) * sd : (iL - y) * sd; };
+        auto inSeg = [&](int y) { return y >= x1 && y <= x2; };
+        if (g < x1)     // segment moves back, g..x1-1 shift up
+            return readingFits(g, x2,
+                [&](int k) { return k < g + len ? segOld(k - g) : k - len; },
+                [&](int y) { return inSeg(y) ? g + segNew(y) : y + len; });
+        int start = g - len;   // segment moves forward, x2+1..g-1 shift down
+        return readingFits(x1, g - 1,
+            [&](int k) { return k >= start ? segOld(k - start) : k + len; },
+            [&](int y) { return inSeg(y) ? start + segNew(y) : y - len; });
+    }
+    // Applies a move; under constraints a move the screen rejects is not made, and one
+    // found infeasible after all is undone (returning false) along with the stops it
+    // queued, or they would retry the same move forever
+    template <typename Move, typename Screen>
+    bool attempt(Move move, Screen screen) {
+        if (!constrained) { move(); return true; }
+        if (!screen()) return false;
+        applied.clear();
+        touchedLo = m;
+        touchedHi = 0;
+        bool dirBefore = dir;
+        size_t queuedBefore = work.size();
+        move();
+        if (touchedLo > touchedHi) return true;
+        if (touchedFeasible()) {
+            double load = loadAfter[readingAt(touchedLo - 1)];
+            for (int k = touchedLo; k <= touchedHi; ++k) {
+                int s = readingAt(k);
+                loadAfter[s] = load += change[s];
+            }
+            return true;
+        }
+        for (size_t r = applied.size(); r-- > 0; ) reverseRange(applied[r].first, applied[r].second);
+        dir = dirBefore;
+        while (work.size() > queuedBefore) { queued[work.back()] = 0; work.pop_back(); }
+        return false;
+    }
+
+    // Reverses the tour path from position i forward to position j, or the complement
+    // when that is shorter (same cycle either way)
+    void reversePath(int i, int j) {
+        int len = (j - i + m) % m + 1;
+        if (2 * len > m) { int ni = (j + 1) % m, nj = (i - 1 + m) % m; i = ni; j = nj; len = m - len; }
+        if (len < 2) return;
+        if (constrained) {
+            // The reading reverses the side without the depot; reversing the side with it
+            // mirrors the whole tour instead, so the reading direction flips
+            bool hasDepot = (pos[0] - i + m) % m < len;
+            int first = hasDepot ? (i + len) % m : i, last = hasDepot ? (i - 1 + m) % m : (i + len - 1) % m;
+            int a = readingIndex(tour[first]), b = readingIndex(tour[last]);
+            touchedLo = min({touchedLo, a, b});
+            touchedHi = max({touchedHi, a, b});
+            applied.push_back({i, len});
+            reverseRange(i, len);
+            if (hasDepot) dir = !dir;
+        } else reverseRange(i, len);
+    }
+    // Reverses len positions starting at i (wrapping); its own inverse
+    void reverseRange(int i, int len) {
+        int j = (i + len - 1) % m;
+        for (int k = 0; k < len / 2; ++k) {
+            int a = tour[i], b = tour[j];
+            tour[i] = b; pos[b] = i;
+            tour[j] = a; pos[a] = j;
+            i = i + 1 == m ? 0 : i + 1;
+            j = j == 0 ? m - 1 : j - 1;
+        }
+    }
+    // Replaces tour edges (a,b) and (c,d) by (a,c) and (b,d); b must follow a in the same
+    // direction that d follows c
+    void move2(int a, int b, int c, int dd) {
+        if (succ(a) != b) { swap(a, b); swap(c, dd); }
+        reversePath(pos[b], pos[c]);
+        push(a); push(b); push(c); push(dd);
+    }
+
+    bool tryTwoOpt(int a) {
+        for (bool forward : {true, false}) {
+            int b = step(a, forward);
+            double dab = d(a, b);
+            for (int c : nbr[a]) {
+                double g1 = dab - d(a, c);
+                if (g1 <= EPS) break;
+                int dd = step(c, forward);
+                if (c == b || dd == a) continue;
+                if (g1 + d(c, dd) - d(b, dd) > EPS && attempt([&] { move2(a, b, c, dd); }, [&] { return twoOptFits(a, b, c, dd); })) {
+                    stats.twoOptMoves++;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // Moves the segment s1..sL (s1 = a, walking in one direction) next to a neighbour c
+    bool tryOrOpt(int a) {
+        for (bool forward : {true, false}) {
+            int sL = a;
+            for (int len = 1; len <= opt.maxSegment && len + 3 <= m; ++len) {
+                if (len > 1) sL = step(sL, forward);
+                int p = step(a, !forward), nn = step(sL, forward);
+                double removeGain = d(p, a) + d(sL, nn) - d(p, nn);
+                if (removeGain <= EPS) continue;
+                for (int c : nbr[a]) {
+                    double g1 = removeGain - d(c, a);
+                    if (g1 <= EPS) break;
+                    if (c == p || c == nn || inSegment(c, a, len, forward)) continue;
+                    for (bool side : {true, false}) {
+                        int e = step(c, side);
+                        if (e == p || e == nn || inSegment(e, a, len, forward)) continue;
+                        if (g1 - d(sL, e) + d(c, e) <= EPS) continue;
+                        if (attempt([&] { moveSegment(p, a, sL, nn, c, e, forward); },
+                                    [&] { return orOptFits(a, sL, len, c, e); })) {
+                            stats.orOptMoves++;
+                            return true;
+                        }
+                    }
+                }
+            }
+        }
+        return false;
+    }
+    bool inSegment(int s, int a, int len, bool forward) const {
+        int off = forward ? (pos[s] - pos[a] + m) % m : (pos[a] - pos[s] + m) % m;
+        return off < len;
+    }
+    // p-s1..sL-nn and c-e become p-nn and c-s1..sL-e, as two or three 2-opt moves
+    void moveSegment(int p, int s1, int sL, int nn, int c, int e, bool forward) {
+        if (!forward) { swap(p, nn); swap(s1, sL); swap(c, e); }   // now p -> s1 .. sL -> nn
+        if (succ(c) == e) {
+            move2(p, s1, c, e);     // p -> c .. nn -> sL .. s1 -> e
+            move2(p, c, nn, sL);    // p -> nn .. c -> sL .. s1 -> e
+            move2(c, sL, s1, e);    // c -> s1 .. sL -> e
+        } else {
+            move2(p, s1, e, c);     // p -> e .. nn -> sL .. s1 -> c
+            move2(p, e, nn, sL);    // p -> nn .. e -> sL .. s1 -> c
+        }
+    }
+
+public:
+    Stats stats;
+
+    RouteLocalSearch(const DistanceMatrix &dm, LocalSearchOptions o = LocalSearchOptions()) : distMat(dm), opt(o) {}
+
+    // Improves route (depot first and last) in place; returns the new length
+    double optimize(vector<int> &route) {
+        constrained = false;
+        return run(route);
+    }
+    // Same for a pickup/delivery route: mate[k] is the other stop of the shipment served at
+    // route[k] (-1 at the depot), load[k] the load change there; route must start feasible
+    double optimize(vector<int> &route, const vector<int> &mates, const vector<double> &load, double cap) {
+        constrained = true;
+        mate.assign(mates.begin(), mates.end() - 1);
+        change.assign(load.begin(), load.end() - 1);
+        isPickup.resize(mate.size());
+        for (size_t k = 0; k < mate.size(); ++k) isPickup[k] = mate[k] > (int)k;
+        capacity = cap;
+        return run(route);
+    }
+    // Original route position of each stop in the optimized route (0 = depot)
+    const vector<int> &stopOrder() const { return order; }
+
+private:
+    double run(vector<int> &route) {
+        stats = Stats();
+        order.resize(route.size());
+        iota(order.begin(), order.end(), 0);
+        if (route.size() < 5) return routeDistance(route, distMat);
+        m = route.size() - 1;
+        node.assign(route.begin(), route.end() - 1);
+        tour.resize(m);
+        pos.resize(m);
+        iota(tour.begin(), tour.end(), 0);
+        iota(pos.begin(), pos.end(), 0);
+        dir = true;
+        if (constrained) {
+            loadAfter.assign(m, 0.0);
+            for (int s = 1; s < m; ++s) loadAfter[s] = loadAfter[s - 1] + change[s];
+        }
+
+        int k = min(opt.neighbors, m - 1);
+        nbr.assign(m, {});
+        vector<pair<double,int>> cand(m);
+        for (int s = 0; s < m; ++s) {
+            auto row = distMat[node[s]];
+            for (int t = 0; t < m; ++t) cand[t] = {t == s ? 1e300 : row[node[t]], t};
+            partial_sort(cand.begin(), cand.begin() + k, cand.end());
+            for (int i = 0; i < k; ++i) nbr[s].push_back(cand[i].second);
+        }
+
+        queued.assign(m, 0);
+        work.clear();
+        for (int s = 0; s < m; ++s) push(s);
+        while (!work.empty()) {
+            int a = work.front(); work.pop_front();
+            queued[a] = 0;
+            if (tryTwoOpt(a) || (opt.maxSegment > 0 && tryOrOpt(a))) push(a);
+        }
+
+        // Back to a depot-first sequence (stop 0 is the depot), read in the feasible direction
+        bool forward = !constrained || dir;
+        for (int i = 0, s = 0; i < m; ++i, s = step(s, forward)) {
+            order[i] = s;
+            route[i] = node[s];
+        }
+        order[m] = m;
+        route[m] = node[0];
+        return routeDistance(route, distMat);
+    }
+};
+
 /* -------------------------
    Assignment & Routing Core
    ------------------------- */
 
-// Build routes for vehicles using greedy nearest neighbor for assigned delivery nodes
-// Route: depot -> pickups/deliveries -> depot (we treat pickup and delivery nodes as single visit nodes)
-// shipmentsMap: map id -> Shipment
-// assigned shipments for a vehicle are provided as vector<int> shipmentIds
-vector<int> buildRouteForVehicle(const Vehicle &veh,
-    const vector<int> &shipmentIds,
-    const unordered_map<int, Shipment> &shipMap,
-    const vector<vector<double>> &distMat)
+// A candidate placement of one shipment: its pickup goes into gap pickGap and its delivery
+// into gap dropGap >= pickGap, where gap g sits just before stop g (gap n = before the
+// final depot). delta is the added distance.
+struct InsertionChoice {
+    double delta = 1e300;
+    int pickGap = -1, dropGap = -1;
+};
+
+// Cheapest feasible placement of a pickup P / delivery Dl pair of weight w in a route of n
+// stops. locAt(k) is the location of stop k (k = -1 or n is the depot) and onboard(k) the
+// load after stop k. A pair (i, j) is feasible when the load plus w stays within capacity
+// after every stop from i-1 to j-1; sweeping j upward carries that running check and the
+// best pickup gap so far, so all O(n^2) pairs are covered in one O(n) pass.
+template <typename LocFn, typename LoadFn, typename DistFn>
+InsertionChoice cheapestPairInsertion(int n, LocFn locAt, LoadFn onboard, double capacity, double w,
+                                      int P, int Dl, DistFn D)
 {
-    // For simplicity, we include pickup and delivery nodes: visit pickup then delivery for each shipment.
-    // A more advanced model would combine pickups and deliveries in same route ordering, respecting capacity timeline.
-    // Here: we will visit pickups first (group), then deliveries, using nearest neighbor heuristic.
-    vector<int> nodes; // remaining nodes to visit
-    // Create sequence of nodes: pickups then deliveries (unique nodes may repeat if same node for multiple shipments)
-    for (int sid : shipmentIds) {
-        nodes.push_back(shipMap.at(sid).pickup);
-        nodes.push_back(shipMap.at(sid).delivery);
-    }
-    // remove duplicates while preserving occurrences: for routing we can keep duplicates as separate visits
-    // Greedy nearest neighbor starting from depot
-    vector<int> route;
-    route.push_back(veh.depot);
-    vector<char> used(nodes.size(), 0);
-
-    int current = veh.depot;
-    for (size_t step = 0; step < nodes.size(); ++step) {
-        double bestD = 1e18;
-        int bestIdx = -1;
-        for (size_t i = 0; i < nodes.size(); ++i) {
-            if (used[i]) continue;
-            double d = distMat[current][nodes[i]];
-            if (d < bestD) { bestD = d; bestIdx = (int)i; }
-        }
-        if (bestIdx == -1) break;
-        used[bestIdx] = 1;
-        route.push_back(nodes[bestIdx]);
-        current = nodes[bestIdx];
-    }
-    // return to depot
+    InsertionChoice best;
+    double bestPick = 1e300;
+    int bestPickGap = -1;
+    for (int j = 0; j <= n; ++j) {
+        if ((j == 0 ? 0.0 : onboard(j - 1)) + w > capacity + 1e-9) { bestPickGap = -1; continue; }
+        int a = locAt(j - 1), b = locAt(j);
+        double ab = D(a, b);
+        double together = D(a, P) + D(P, Dl) + D(Dl, b) - ab;
+        if (together < best.delta) best = {together, j, j};
+        if (bestPickGap >= 0) {
+            double apart = bestPick + D(a, Dl) + D(Dl, b) - ab;
+            if (apart < best.delta) best = {apart, bestPickGap, j};
+        }
+        double pickHere = D(a, P) + D(P, b) - ab;
+        if (bestPickGap < 0 || pickHere < bestPick) { bestPick = pickHere; bestPickGap = j; }
+    }
+    return best;
+}
+
+// A vehicle's route under construction: stops between the two depot visits, the shipment
+// behind each stop, the load after each stop (prefix sums of +w pickups, -w deliveries)
+// and the route length, which Vehicle::maxRouteKm caps
+struct RouteBuild {
+    vector<int> nodes;
+    vector<int> shipment;     // index into the shipment list
+    vector<double> onboard;
+    double distance = 0;
+
+    int locAt(const Vehicle &veh, int k) const { return k < 0 || k >= (int)nodes.size() ? veh.depot : nodes[k]; }
+
+    InsertionChoice cheapest(const Vehicle &veh, const Shipment &s, const DistanceMatrix &distMat) const {
+        InsertionChoice c = cheapestPairInsertion(nodes.size(),
+            [&](int k) { return locAt(veh, k); },
+            [&](int k) { return onboard[k]; },
+            veh.capacity, s.weight, s.pickup, s.delivery,
+            [&](int a, int b) { return distMat[a][b]; });
+        // Every other placement adds more distance, so if the cheapest one overruns the
+        // shift none fits
+        if (veh.maxRouteKm > 0 && distance + c.delta > veh.maxRouteKm + 1e-9) return InsertionChoice();
+        return c;
+    }
+    void insert(int sIdx, const Shipment &s, const InsertionChoice &c) {
+        nodes.insert(nodes.begin() + c.dropGap, s.delivery);
+        shipment.insert(shipment.begin() + c.dropGap, sIdx);
+        onboard.insert(onboard.begin() + c.dropGap, 0.0);
+        nodes.insert(nodes.begin() + c.pickGap, s.pickup);
+        shipment.insert(shipment.begin() + c.pickGap, sIdx);
+        onboard.insert(onboard.begin() + c.pickGap, 0.0);
+        // Only the stops carried between the new pickup and delivery change
+        int p = c.pickGap, d = c.dropGap + 1;
+        onboard[p] = (p == 0 ? 0.0 : onboard[p - 1]) + s.weight;
+        for (int k = p + 1; k < d; ++k) onboard[k] += s.weight;
+        onboard[d] = onboard[d - 1] - s.weight;
+        distance += c.delta;
+    }
+    // Takes shipment sIdx out; returns its old placement with delta = the distance saved,
+    // so insert() with the result puts it back
+    InsertionChoice erase(int sIdx, const Shipment &s, const Vehicle &veh, const DistanceMatrix &distMat) {
+        int p = find(shipment.begin(), shipment.end(), sIdx) - shipment.begin();
+        int d = find(shipment.begin() + p + 1, shipment.end(), sIdx) - shipment.begin();
+        auto detour = [&](int a, int x, int b) { return distMat[a][x] + distMat[x][b] - distMat[a][b]; };
+        double saved;
+        if (d == p + 1) {
+            int a = locAt(veh, p - 1), b = locAt(veh, d + 1);
+            saved = distMat[a][s.pickup] + distMat[s.pickup][s.delivery] + distMat[s.delivery][b] - distMat[a][b];
+        } else {
+            saved = detour(locAt(veh, p - 1), s.pickup, locAt(veh, p + 1)) + detour(locAt(veh, d - 1), s.delivery, locAt(veh, d + 1));
+        }
+        for (int k = p + 1; k < d; ++k) onboard[k] -= s.weight;
+        for (int k : {d, p}) {
+            nodes.erase(nodes.begin() + k);
+            shipment.erase(shipment.begin() + k);
+            onboard.erase(onboard.begin() + k);
+        }
+        distance -= saved;
+        return {saved, p, d - 1};
+    }
+    double peakLoad() const { return onboard.empty() ? 0.0 : *max_element(onboard.begin(), onboard.end()); }
+};
+
+// Route improvement that keeps precedence, capacity and the shift limit: take each shipment
+// out and put it back at its cheapest feasible place, until a pass finds nothing
+void improveByReinsertion(RouteBuild &rb, const Vehicle &veh, const vector<Shipment> &shipments,
+                          const DistanceMatrix &distMat, int maxPasses = 5)
+{
+    for (int pass = 0; pass < maxPasses; ++pass) {
+        bool improved = false;
+        vector<int> order = rb.shipment;
+        sort(order.begin(), order.end());
+        order.erase(unique(order.begin(), order.end()), order.end());
+        for (int sIdx : order) {
+            const Shipment &s = shipments[sIdx];
+            InsertionChoice old = rb.erase(sIdx, s, veh, distMat);
+            InsertionChoice c = rb.cheapest(veh, s, distMat);
+            if (c.pickGap >= 0 && c.delta < old.delta - 1e-7) { rb.insert(sIdx, s, c); improved = true; }
+            else rb.insert(sIdx, s, old);
+        }
+        if (!improved) break;
+    }
+}
+
+// Neighbor-list 2-opt / Or-opt over the whole route, for the gains reinsertion of single
+// shipments cannot reach; moves that break pickup-before-delivery or capacity are undone
+void improveByLocalSearch(RouteBuild &rb, const Vehicle &veh, const vector<Shipment> &shipments,
+                          const DistanceMatrix &distMat)
+{
+    int n = rb.nodes.size();
+    vector<int> route(1, veh.depot), mate(n + 2, -1);
+    vector<double> load(n + 2, 0.0);
+    route.insert(route.end(), rb.nodes.begin(), rb.nodes.end());
     route.push_back(veh.depot);
-    return route;
+    unordered_map<int, int> pickupAt;
+    for (int k = 0; k < n; ++k) {
+        int sIdx = rb.shipment[k];
+        auto it = pickupAt.find(sIdx);
+        if (it == pickupAt.end()) {
+            pickupAt[sIdx] = k + 1;
+            load[k + 1] = shipments[sIdx].weight;
+        } else {
+            mate[k + 1] = it->second;
+            mate[it->second] = k + 1;
+            load[k + 1] = -shipments[sIdx].weight;
+        }
+    }
+    RouteLocalSearch ls(distMat);
+    double len = ls.optimize(route, mate, load, veh.capacity);
+    if (len >= rb.distance - 1e-7) return;
+
+    const vector<int> &order = ls.stopOrder();
+    vector<int> nodes(n), shipment(n);
+    for (int i = 0; i < n; ++i) {
+        nodes[i] = rb.nodes[order[i + 1] - 1];
+        shipment[i] = rb.shipment[order[i + 1] - 1];
+        rb.onboard[i] = (i == 0 ? 0.0 : rb.onboard[i - 1]) + load[order[i + 1]];
+    }
+    rb.nodes.swap(nodes);
+    rb.shipment.swap(shipment);
+    rb.distance = len;
 }
 
 /* -------------------------
@@ -179,8 +801,12 @@ vector<int> buildRouteForVehicle(const Vehicle &veh,
    ------------------------- */
 // Approach:
 // - Put shipments into max-heap by priority (higher first), break ties by heavier weight.
-// - For each shipment, find the vehicle with enough spare capacity that yields smallest marginal distance increase.
-// - If none fits, open new vehicle (if available) or mark as unassigned.
+// - For each shipment, find the vehicle whose route takes it at the smallest added cost,
+//   placing pickup and delivery in the cheapest gaps that keep pickup before delivery and
+//   the load on board within capacity at every stop.
+// - If no vehicle can take it, mark as unassigned.
+// - Finally improve each route by reinserting its shipments one at a time, then by
+//   precedence-checked 2-opt / Or-opt moves.
 
 struct ShipmentHeapItem {
     int sid;
@@ -194,85 +820,74 @@ struct SHComp {
     }
 };
 
-// compute marginal insertion cost if we simply append pickup+delivery into existing route at best positions.
-// For simplicity, we'll compute estimated marginal cost as dist(depot->pickup->delivery->depot) if vehicle has no route,
-// otherwise incremental estimate: dist(lastNode, pickup) + dist(pickup, delivery) + dist(delivery, depot) - dist(lastNode, depot)
-double estimatedMarginalCostAppend(const Vehicle &veh, const Shipment &s, const vector<vector<double>> &distMat) {
-    int depot = veh.depot;
-    double lastToDepot = 0;
-    if (veh.route.empty()) lastToDepot = 0;
-    else {
-        int lastNode = veh.route.back();
-        lastToDepot = distMat[lastNode][depot];
-    }
-    double lastToPickup = veh.route.empty() ? distMat[depot][s.pickup] : distMat[veh.route.back()][s.pickup];
-    double costNew = lastToPickup + distMat[s.pickup][s.delivery] + distMat[s.delivery][depot];
-    double costOld = lastToDepot;
-    return costNew - costOld;
-}
-
 // perform greedy packing & routing assignment
 void assignShipmentsToVehicles(
     const vector<Shipment> &shipments,
     vector<Vehicle> &vehicles,
-    const vector<vector<double>> &distMat,
+    const DistanceMatrix &distMat,
     unordered_map<int, Shipment> &shipMap,
     vector<int> &unassigned)
 {
     // build priority heap
     priority_queue<ShipmentHeapItem, vector<ShipmentHeapItem>, SHComp> heap;
-    for (auto &s : shipments) {
+    unordered_map<int, int> indexOf;
+    for (int i = 0; i < (int)shipments.size(); ++i) {
+        const auto &s = shipments[i];
         heap.push({s.id, s.priority, s.weight});
         shipMap[s.id] = s;
+        indexOf[s.id] = i;
     }
 
     // Reset vehicle assigned info
     for (auto &v : vehicles) {
         v.assignedShipments.clear();
         v.loadAssigned = 0;
+        v.peakLoad = 0;
         v.route.clear();
+        v.routeShipments.clear();
     }
+    vector<RouteBuild> builds(vehicles.size());
 
     while (!heap.empty()) {
         auto top = heap.top(); heap.pop();
         int sid = top.sid;
-        Shipment s = shipMap[sid];
+        const Shipment &s = shipMap[sid];
 
-        // scan vehicles for feasible insertion (capacity)
-        double bestCost = 1e18;
+        // scan vehicles for the cheapest feasible insertion (distance added x cost per km)
+        InsertionChoice best;
+        double bestCost = 1e300;
         int bestVid = -1;
-
         for (int vid = 0; vid < (int)vehicles.size(); ++vid) {
-            auto &veh = vehicles[vid];
-            if (veh.loadAssigned + s.weight <= veh.capacity) {
-                double marginal = estimatedMarginalCostAppend(veh, s, distMat);
-                if (marginal < bestCost) {
-                    bestCost = marginal;
-                    bestVid = vid;
-                }
+            InsertionChoice c = builds[vid].cheapest(vehicles[vid], s, distMat);
+            if (c.pickGap >= 0 && c.delta * vehicles[vid].costPerKm < bestCost) {
+                best = c;
+                bestCost = c.delta * vehicles[vid].costPerKm;
+                bestVid = vid;
             }
         }
 
         if (bestVid == -1) {
-            // no vehicle fits; try to find any vehicle with remaining capacity (allow splitting? here we don't split)
+            // no vehicle can carry it anywhere along its route (we don't split shipments)
             unassigned.push_back(sid);
         } else {
-            // assign to best vehicle
+            builds[bestVid].insert(indexOf[sid], s, best);
             vehicles[bestVid].assignedShipments.push_back(sid);
             vehicles[bestVid].loadAssigned += s.weight;
-            // build route incrementally (append) -- we'll rebuild full route later
-            // For now we append nodes to route to approximate
-            vehicles[bestVid].route.push_back(s.pickup);
-            vehicles[bestVid].route.push_back(s.delivery);
         }
     }
 
-    // After assignment, rebuild and optimize routes for each vehicle
-    for (auto &veh : vehicles) {
-        // deduplicate simple route and convert to proper sequence: we'll rebuild using assigned shipments
-        veh.route = buildRouteForVehicle(veh, veh.assignedShipments, shipMap, distMat);
-        // Improve route using 2-opt
-        twoOptLoop(veh.route, distMat, 200);
+    // After assignment, improve each route and write it out depot -> stops -> depot
+    for (size_t vid = 0; vid < vehicles.size(); ++vid) {
+        auto &veh = vehicles[vid];
+        improveByReinsertion(builds[vid], veh, shipments, distMat);
+        improveByLocalSearch(builds[vid], veh, shipments, distMat);
+        veh.route.assign(1, veh.depot);
+        veh.route.insert(veh.route.end(), builds[vid].nodes.begin(), builds[vid].nodes.end());
+        veh.route.push_back(veh.depot);
+        veh.routeShipments.assign(1, -1);
+        for (int sIdx : builds[vid].shipment) veh.routeShipments.push_back(shipments[sIdx].id);
+        veh.routeShipments.push_back(-1);
+        veh.peakLoad = builds[vid].peakLoad();
     }
 }
 
@@ -292,7 +907,7 @@ struct Metrics {
 
 Metrics evaluateSolution(const vector<Vehicle> &vehicles,
                          const unordered_map<int, Shipment> &shipMap,
-                         const vector<vector<double>> &distMat)
+                         const DistanceMatrix &distMat)
 {
     Metrics m;
     for (const auto &veh : vehicles) {
@@ -310,6 +925,792 @@ Metrics evaluateSolution(const vector<Vehicle> &vehicles,
     return m;
 }
 
+/* -------------------------
+   Adaptive Large Neighborhood Search (parallel, time-budgeted)
+   ------------------------- */
+// Each thread runs its own ALNS: destroy q shipments (random, worst-cost or Shaw
+// related removal), re-insert them (greedy or regret-2/3 cheapest insertion), and accept
+// the result by simulated annealing on a wall-clock temperature schedule. Operator
+// weights adapt to how often each one produces new bests / improvements / accepted moves.
+// Threads publish improvements to a shared best and jump to it when they fall behind.
+// Feasibility matches the greedy assigner: each pickup is visited before its delivery on
+// the same vehicle, the load on board never exceeds Vehicle::capacity, and routes stay
+// within Vehicle::maxRouteKm.
+
+struct AlnsConfig {
+    double timeBudgetSec = 1.0;
+    int threads = 0;                   // 0 = all hardware threads
+    unsigned seed = 1;
+    double minRemoveFrac = 0.05, maxRemoveFrac = 0.3;
+    int maxRemove = 60;
+    double unassignedPenalty = 1e5;    // cost per shipment left unassigned
+    double startAcceptWorse = 0.05;    // 5% worse accepted with p = 0.5 at the start...
+    double endTemperatureRatio = 0.002;// ...cooling to this fraction of the start temperature
+    int segment = 100;                 // iterations between operator weight updates
+    double reaction = 0.1;
+    int syncEvery = 250;               // iterations between looks at the shared best
+};
+
+struct AlnsResult {
+    double cost = 0;                   // routing cost plus unassigned penalty
+    double distance = 0;
+    int unassigned = 0;
+    long long iterations = 0;
+    vector<pair<double,double>> curve; // (seconds, best cost) at every global improvement
+};
+
+class AlnsSolver {
+    // Problem data in a compact local index: locations 0..L-1, float distance table
+    int S = 0, V = 0, L = 0;
+    vector<float> dist;
+    vector<int> pickLoc, dropLoc, depotLoc, locNode;
+    vector<double> weight, capacity, costPerKm, maxKm;
+    const AlnsConfig cfg;
+
+    struct State {
+        vector<vector<int>> routes;    // stop codes: 2s = pickup of s, 2s+1 = delivery of s
+        vector<vector<double>> onboard;// load after each stop
+        vector<double> cost;           // per vehicle
+        vector<int> vehicleOf;         // -1 = unassigned
+        double total = 0;              // recomputed from cost[] and unassignedCount, never accumulated
+        int unassignedCount = 0;
+    };
+    using Insertion = InsertionChoice;
+
+    double D(int a, int b) const { return dist[(size_t)a * L + b]; }
+    int locOf(int code) const { return code & 1 ? dropLoc[code >> 1] : pickLoc[code >> 1]; }
+
+    double routeCost(int v, const vector<int> &stops) const {
+        int prev = depotLoc[v];
+        double d = 0;
+        for (int c : stops) { d += D(prev, locOf(c)); prev = locOf(c); }
+        return (d + D(prev, depotLoc[v])) * costPerKm[v];
+    }
+    // Improvement test with a tolerance relative to the cost, which is dominated by the
+    // unassigned penalty while shipments are left over
+    static bool better(double a, double b) { return a < b - 1e-9 * fabs(b); }
+
+    void refresh(State &st, int v) const {
+        st.cost[v] = routeCost(v, st.routes[v]);
+        st.total = accumulate(st.cost.begin(), st.cost.end(), 0.0) + st.unassignedCount * cfg.unassignedPenalty;
+        const vector<int> &r = st.routes[v];
+        vector<double> &ob = st.onboard[v];
+        ob.resize(r.size());
+        double load = 0;
+        for (size_t k = 0; k < r.size(); ++k) ob[k] = load += r[k] & 1 ? -weight[r[k] >> 1] : weight[r[k] >> 1];
+    }
+
+    // Cheapest feasible pickup gap <= delivery gap in route v, O(route length)
+    Insertion bestInsertion(const State &st, int s, int v) const {
+        const vector<int> &r = st.routes[v];
+        const vector<double> &ob = st.onboard[v];
+        int k = r.size(), depot = depotLoc[v];
+        Insertion best = cheapestPairInsertion(k,
+            [&](int idx) { return idx < 0 || idx >= k ? depot : locOf(r[idx]); },
+            [&](int idx) { return ob[idx]; },
+            capacity[v], weight[s], pickLoc[s], dropLoc[s],
+            [&](int a, int b) { return D(a, b); });
+        if (best.pickGap < 0) return best;
+        if (maxKm[v] > 0 && st.cost[v] / costPerKm[v] + best.delta > maxKm[v] + 1e-9) return Insertion();
+        best.delta *= costPerKm[v];
+        return best;
+    }
+    void insert(State &st, int s, int v, const Insertion &ins) const {
+        vector<int> &r = st.routes[v];
+        r.insert(r.begin() + ins.dropGap, 2 * s + 1);
+        r.insert(r.begin() + ins.pickGap, 2 * s);
+        st.vehicleOf[s] = v;
+        st.unassignedCount--;
+        refresh(st, v);
+    }
+    void remove(State &st, int s) const {
+        int v = st.vehicleOf[s];
+        if (v < 0) return;
+        vector<int> &r = st.routes[v];
+        r.erase(remove_if(r.begin(), r.end(), [&](int c) { return (c >> 1) == s; }), r.end());
+        st.vehicleOf[s] = -1;
+        st.unassignedCount++;
+        refresh(st, v);
+    }
+
+    /* ---- destroy operators: return the shipments taken out ---- */
+
+    vector<int> assignedShipments(const State &st) const {
+        vector<int> out;
+        for (int s = 0; s < S; ++s) if (st.vehicleOf[s] >= 0) out.push_back(s);
+        return out;
+    }
+    void randomRemoval(State &st, int q, mt19937 &rng) const {
+        vector<int> cand = assignedShipments(st);
+        shuffle(cand.begin(), cand.end(), rng);
+        for (int i = 0; i < q && i < (int)cand.size(); ++i) remove(st, cand[i]);
+    }
+    // Biased towards shipments whose removal saves the most
+    void worstRemoval(State &st, int q, mt19937 &rng) const {
+        vector<pair<double,int>> saving;
+        for (int s : assignedShipments(st)) {
+            int v = st.vehicleOf[s];
+            vector<int> r = st.routes[v];
+            r.erase(remove_if(r.begin(), r.end(), [&](int c) { return (c >> 1) == s; }), r.end());
+            saving.push_back({st.cost[v] - routeCost(v, r), s});
+        }
+        sort(saving.rbegin(), saving.rend());
+        uniform_real_distribution<double> U(0, 1);
+        for (int i = 0; i < q && !saving.empty(); ++i) {
+            int pick = (int)(pow(U(rng), 4) * saving.size());
+            remove(st, saving[pick].second);
+            saving.erase(saving.begin() + pick);
+        }
+    }
+    // Shaw: shipments with nearby pickups, nearby deliveries and similar weight
+    void shawRemoval(State &st, int q, mt19937 &rng) const {
+        vector<int> cand = assignedShipments(st);
+        if (cand.empty()) return;
+        uniform_real_distribution<double> U(0, 1);
+        vector<int> removed = {cand[rng() % cand.size()]};
+        cand.erase(find(cand.begin(), cand.end(), removed[0]));
+        while ((int)removed.size() < q && !cand.empty()) {
+            int r = removed[rng() % removed.size()];
+            auto related = [&](int s) {
+                return D(pickLoc[r], pickLoc[s]) + D(dropLoc[r], dropLoc[s]) + 10.0 * fabs(weight[r] - weight[s]);
+            };
+            sort(cand.begin(), cand.end(), [&](int a, int b) { return related(a) < related(b); });
+            int pick = (int)(pow(U(rng), 6) * cand.size());
+            removed.push_back(cand[pick]);
+            cand.erase(cand.begin() + pick);
+        }
+        for (int s : removed) remove(st, s);
+    }
+
+    /* ---- repair operators: insert every unassigned shipment that fits somewhere ---- */
+
+    // regretK = 1 is plain greedy (cheapest insertion first); 2 or 3 inserts first the
+    // shipment that loses most by not getting its best vehicle
+    void regretInsertion(State &st, int regretK) const {
+        vector<int> pool;
+        for (int s = 0; s < S; ++s) if (st.vehicleOf[s] < 0) pool.push_back(s);
+        vector<vector<Insertion>> table(pool.size(), vector<Insertion>(V));
+        for (size_t i = 0; i < pool.size(); ++i)
+            for (int v = 0; v < V; ++v) table[i][v] = bestInsertion(st, pool[i], v);
+        const double BIG = 1e12;
+        while (!pool.empty()) {
+            int bestI = -1, bestV = -1;
+            double bestScore = -1e300, bestCost = 1e300;
+            for (size_t i = 0; i < pool.size(); ++i) {
+                double c[3] = {1e300, 1e300, 1e300};
+                int v1 = -1;
+                for (int v = 0; v < V; ++v) {
+                    double x = table[i][v].delta;
+                    if (x < c[0]) { c[2] = c[1]; c[1] = c[0]; c[0] = x; v1 = v; }
+                    else if (x < c[1]) { c[2] = c[1]; c[1] = x; }
+                    else if (x < c[2]) c[2] = x;
+                }
+                if (v1 < 0 || c[0] >= 1e299) continue;
+                double score = 0;
+                if (regretK == 1) score = -c[0];
+                else for (int h = 1; h < regretK; ++h) score += min(c[h], BIG) - c[0];
+                if (score > bestScore || (score == bestScore && c[0] < bestCost)) {
+                    bestScore = score; bestCost = c[0]; bestI = i; bestV = v1;
+                }
+            }
+            if (bestI < 0) break;   // nothing left fits anywhere
+            insert(st, pool[bestI], bestV, table[bestI][bestV]);
+            pool.erase(pool.begin() + bestI);
+            table.erase(table.begin() + bestI);
+            for (size_t i = 0; i < pool.size(); ++i) table[i][bestV] = bestInsertion(st, pool[i], bestV);
+        }
+    }
+
+    /* ---- search ---- */
+
+    struct Shared {
+        mutex lock;
+        State best;
+        double bestCost = 1e300;
+        vector<pair<double,double>> curve;
+        chrono::steady_clock::time_point start;
+        atomic<long long> iterations{0};
+    };
+
+    void publish(Shared &sh, const State &st) const {
+        lock_guard<mutex> g(sh.lock);
+        if (!better(st.total, sh.bestCost)) return;
+        sh.best = st;
+        sh.bestCost = st.total;
+        sh.curve.push_back({chrono::duration<double>(chrono::steady_clock::now() - sh.start).count(), st.total});
+    }
+
+    void searchThread(Shared &sh, State current, unsigned seed) const {
+        mt19937 rng(seed);
+        uniform_real_distribution<double> U(0, 1);
+        const int DESTROY = 3, REPAIR = 3;
+        double dw[DESTROY] = {1, 1, 1}, rw[REPAIR] = {1, 1, 1};
+        double dScore[DESTROY] = {}, rScore[REPAIR] = {};
+        int dUsed[DESTROY] = {}, rUsed[REPAIR] = {};
+        auto roulette = [&](const double *w, int n) {
+            double sum = 0;
+            for (int i = 0; i < n; ++i) sum += w[i];
+            double x = U(rng) * sum;
+            for (int i = 0; i < n; ++i) if ((x -= w[i]) <= 0) return i;
+            return n - 1;
+        };
+
+        State best = current;
+        double T0 = cfg.startAcceptWorse * max(1.0, current.total - current.unassignedCount * cfg.unassignedPenalty) / log(2.0);
+        int qMin = max(1, (int)(cfg.minRemoveFrac * S)), qMax = max(qMin, min(cfg.maxRemove, (int)(cfg.maxRemoveFrac * S)));
+        for (long long it = 1;; ++it) {
+            double elapsed = chrono::duration<double>(chrono::steady_clock::now() - sh.start).count();
+            if (elapsed >= cfg.timeBudgetSec) break;
+            double T = T0 * pow(cfg.endTemperatureRatio, elapsed / cfg.timeBudgetSec);
+
+            State cand = current;
+            int q = qMin + rng() % (qMax - qMin + 1);
+            int d = roulette(dw, DESTROY), r = roulette(rw, REPAIR);
+            if (d == 0) randomRemoval(cand, q, rng);
+            else if (d == 1) worstRemoval(cand, q, rng);
+            else shawRemoval(cand, q, rng);
+            regretInsertion(cand, r + 1);
+
+            double score = 0;
+            if (better(cand.total, best.total)) { best = cand; current = cand; score = 33; publish(sh, best); }
+            else if (better(cand.total, current.total)) { current = cand; score = 9; }
+            else if (U(rng) < exp((current.total - cand.total) / max(T, 1e-12))) { current = cand; score = 13; }
+            dScore[d] += score; dUsed[d]++;
+            rScore[r] += score; rUsed[r]++;
+
+            if (it % cfg.segment == 0) {
+                for (int i = 0; i < DESTROY; ++i) if (dUsed[i]) dw[i] = dw[i] * (1 - cfg.reaction) + cfg.reaction * dScore[i] / dUsed[i];
+                for (int i = 0; i < REPAIR; ++i) if (rUsed[i]) rw[i] = rw[i] * (1 - cfg.reaction) + cfg.reaction * rScore[i] / rUsed[i];
+                for (int i = 0; i < DESTROY; ++i) { dw[i] = max(dw[i], 0.05); dScore[i] = 0; dUsed[i] = 0; }
+                for (int i = 0; i < REPAIR; ++i) { rw[i] = max(rw[i], 0.05); rScore[i] = 0; rUsed[i] = 0; }
+            }
+            if (it % cfg.syncEvery == 0) {
+                lock_guard<mutex> g(sh.lock);
+                if (sh.bestCost < best.total * (1 - 1e-3)) { best = sh.best; current = sh.best; }
+            }
+            sh.iterations++;
+        }
+    }
+
+public:
+    AlnsSolver(const vector<Shipment> &shipments, const vector<Vehicle> &vehicles, const DistanceMatrix &distMat,
+               const AlnsConfig &config)
+        : S(shipments.size()), V(vehicles.size()), cfg(config)
+    {
+        unordered_map<int,int> local;
+        auto loc = [&](int node) {
+            auto it = local.find(node);
+            if (it != local.end()) return it->second;
+            local[node] = locNode.size();
+            locNode.push_back(node);
+            return (int)locNode.size() - 1;
+        };
+        for (auto &v : vehicles) {
+            depotLoc.push_back(loc(v.depot));
+            capacity.push_back(v.capacity);
+            maxKm.push_back(v.maxRouteKm);
+            costPerKm.push_back(v.costPerKm);
+        }
+        for (auto &s : shipments) {
+            pickLoc.push_back(loc(s.pickup));
+            dropLoc.push_back(loc(s.delivery));
+            weight.push_back(s.weight);
+        }
+        // One copy out of the (possibly lazy) matrix; threads only read this table
+        L = locNode.size();
+        dist.resize((size_t)L * L);
+        for (int a = 0; a < L; ++a) {
+            auto row = distMat[locNode[a]];
+            for (int b = 0; b < L; ++b) dist[(size_t)a * L + b] = row[locNode[b]];
+        }
+    }
+
+    AlnsResult solve(vector<vector<int>> &routeStops, vector<int> &vehicleOf) const {
+        State init;
+        init.routes.assign(V, {});
+        init.onboard.assign(V, {});
+        init.cost.assign(V, 0);
+        init.vehicleOf.assign(S, -1);
+        init.unassignedCount = S;
+        for (int v = 0; v < V; ++v) refresh(init, v);
+        regretInsertion(init, 1);
+
+        Shared sh;
+        sh.start = chrono::steady_clock::now();
+        sh.best = init;
+        sh.bestCost = init.total;
+        sh.curve.push_back({0.0, init.total});
+        int threads = cfg.threads > 0 ? cfg.threads : (int)max(1u, thread::hardware_concurrency());
+        if (S > 0 && V > 0) {
+            vector<thread> pool;
+            for (int t = 0; t < threads; ++t)
+                pool.emplace_back([&, t]() { searchThread(sh, init, cfg.seed * 7919 + t); });
+            for (auto &th : pool) th.join();
+        }
+
+        AlnsResult res;
+        res.cost = sh.bestCost;
+        res.unassigned = sh.best.unassignedCount;
+        for (int v = 0; v < V; ++v) res.distance += sh.best.cost[v] / costPerKm[v];
+        res.iterations = sh.iterations;
+        res.curve = sh.curve;
+        routeStops = sh.best.routes;
+        vehicleOf = sh.best.vehicleOf;
+        return res;
+    }
+    int locationNode(int code, const vector<Shipment> &shipments) const {
+        const Shipment &s = shipments[code >> 1];
+        return code & 1 ? s.delivery : s.pickup;
+    }
+};
+
+// Same contract as assignShipmentsToVehicles: fills vehicle routes, assignments and loads,
+// shipMap, and the ids that could not be placed
+AlnsResult solveWithAlns(const vector<Shipment> &shipments, vector<Vehicle> &vehicles, const DistanceMatrix &distMat,
+                         unordered_map<int, Shipment> &shipMap, vector<int> &unassigned,
+                         const AlnsConfig &cfg = AlnsConfig())
+{
+    AlnsSolver solver(shipments, vehicles, distMat, cfg);
+    vector<vector<int>> routeStops;
+    vector<int> vehicleOf;
+    AlnsResult res = solver.solve(routeStops, vehicleOf);
+
+    for (auto &s : shipments) shipMap[s.id] = s;
+    for (size_t v = 0; v < vehicles.size(); ++v) {
+        Vehicle &veh = vehicles[v];
+        veh.assignedShipments.clear();
+        veh.loadAssigned = 0;
+        veh.peakLoad = 0;
+        veh.route = {veh.depot};
+        veh.routeShipments = {-1};
+        double load = 0;
+        for (int code : routeStops[v]) {
+            const Shipment &s = shipments[code >> 1];
+            veh.route.push_back(solver.locationNode(code, shipments));
+            veh.routeShipments.push_back(s.id);
+            load += code & 1 ? -s.weight : s.weight;
+            veh.peakLoad = max(veh.peakLoad, load);
+            if (code & 1) continue;
+            veh.assignedShipments.push_back(s.id);
+            veh.loadAssigned += s.weight;
+        }
+        veh.route.push_back(veh.depot);
+        veh.routeShipments.push_back(-1);
+    }
+    for (size_t s = 0; s < shipments.size(); ++s)
+        if (vehicleOf[s] < 0) unassigned.push_back(shipments[s].id);
+    return res;
+}
+
+/* -------------------------
+   Benchmarks
+   ------------------------- */
+// Run with: ./transport_opt --bench [name] [size]   (no name = all)
+
+long long benchSize = 0;   // optional third argument, e.g. network size
+
+double secondsSince(chrono::steady_clock::time_point t0) {
+    return chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+}
+
+// Road-like network: a grid of junctions with 1-20 km links; every tenth north-south link
+// is missing, except in the first column, so the network stays connected
+Graph makeFreightNetwork(int n, mt19937 &rng) {
+    int side = max(1, (int)ceil(sqrt((double)n)));
+    Graph g(n);
+    auto link = [&](int u, int v) {
+        double d = 1 + rng() % 20;
+        g[u].push_back(Edge(v, d));
+        g[v].push_back(Edge(u, d));
+    };
+    for (int u = 0; u < n; ++u) {
+        int c = u % side;
+        if (c + 1 < side && u + 1 < n) link(u, u + 1);
+        if (u + side < n && (rng() % 10 != 0 || c == 0)) link(u, u + side);
+    }
+    return g;
+}
+
+// Random fleet and shipment book over a network of n nodes
+void makeFreightBook(int n, int vehicleCount, int shipmentCount, mt19937 &rng,
+                     vector<Vehicle> &vehicles, vector<Shipment> &shipments)
+{
+    vehicles.clear();
+    shipments.clear();
+    for (int v = 0; v < vehicleCount; ++v)
+        vehicles.push_back({v + 1, (int)(rng() % n), 8.0 + rng() % 12, 1.2 + (rng() % 6) / 10.0, 0.2 + (rng() % 10) / 100.0});
+    for (int s = 0; s < shipmentCount; ++s)
+        shipments.push_back({s + 1, (int)(rng() % n), (int)(rng() % n), 0.5 + (rng() % 40) / 10.0,
+                             (int)(rng() % 10) + 1, (double)(rng() % 12)});
+}
+
+void benchDistanceMatrix() {
+    const int N = benchSize > 0 ? (int)benchSize : 20000;
+    const int SMALL = min(N, 2000), VEHICLES = 60, SHIPMENTS = 600;
+    unsigned hw = max(1u, thread::hardware_concurrency());
+    mt19937 rng(10);
+
+    // Old nested vectors against the flat matrix on a size both can hold
+    Graph small = makeFreightNetwork(SMALL, rng);
+    auto t0 = chrono::steady_clock::now();
+    auto nested = allPairsShortest(small);
+    double nestedSec = secondsSince(t0);
+    DistanceMatrix flat1, flatAll;
+    t0 = chrono::steady_clock::now();
+    flat1.buildDense(small, 1);
+    double flat1Sec = secondsSince(t0);
+    t0 = chrono::steady_clock::now();
+    flatAll.buildDense(small);
+    double flatAllSec = secondsSince(t0);
+    bool ok = true;
+    for (int u = 0; u < SMALL; ++u)
+        for (int v = 0; v < SMALL; ++v)
+            ok = ok && fabs(flatAll[u][v] - nested[u][v]) <= 1e-6 * max(1.0, nested[u][v]) && flat1[u][v] == flatAll[u][v];
+    // A prefetch larger than the cache keeps every row it hands to the workers distinct
+    DistanceMatrix tiny;
+    tiny.buildLazy(small, 2);
+    tiny.at(0, 0);
+    tiny.prefetch({1, 0, 2});
+    bool tinyOk = tiny.rowsComputed() == 2;
+    for (int u : {1, 0, 2})
+        for (int v = 0; v < SMALL; ++v) tinyOk = tinyOk && tiny[u][v] == flatAll[u][v];
+    cout << "Distance matrix, " << SMALL << " nodes" << (ok ? "" : "  (MISMATCH)")
+         << (tinyOk ? "" : "  (PREFETCH OVERFLOW)") << "\n";
+    cout << "  nested vector<double>, 1 thread: " << nestedSec * 1e3 << " ms, "
+         << ((size_t)SMALL * SMALL * 8 + SMALL * sizeof(vector<double>)) / (1 << 20) << " MiB\n";
+    cout << "  flat float32, 1 thread: " << flat1Sec * 1e3 << " ms; " << hw << " thread(s): " << flatAllSec * 1e3
+         << " ms, " << flatAll.memoryBytes() / (1 << 20) << " MiB\n";
+
+    // Full size: dense (if it fits) against lazy rows for the nodes a fleet actually visits
+    Graph g = makeFreightNetwork(N, rng);
+    vector<Vehicle> vehicles;
+    vector<Shipment> shipments;
+    makeFreightBook(N, VEHICLES, SHIPMENTS, rng, vehicles, shipments);
+    vector<int> hot;
+    for (auto &v : vehicles) hot.push_back(v.depot);
+    for (auto &s : shipments) { hot.push_back(s.pickup); hot.push_back(s.delivery); }
+    sort(hot.begin(), hot.end());
+    hot.erase(unique(hot.begin(), hot.end()), hot.end());
+
+    DistanceMatrix lazy;
+    t0 = chrono::steady_clock::now();
+    lazy.buildLazy(g, hot.size());
+    lazy.prefetch(hot);
+    double lazySec = secondsSince(t0);
+    vector<Vehicle> lazyFleet = vehicles;
+    unordered_map<int, Shipment> shipMap;
+    vector<int> unassigned;
+    t0 = chrono::steady_clock::now();
+    assignShipmentsToVehicles(shipments, lazyFleet, lazy, shipMap, unassigned);
+    double assignSec = secondsSince(t0);
+    Metrics lazyMetrics = evaluateSolution(lazyFleet, shipMap, lazy);
+    cout << "Distance matrix, " << N << " nodes, " << VEHICLES << " vehicles, " << SHIPMENTS << " shipments\n";
+    cout << "  lazy rows: " << hot.size() << " rows prefetched in " << lazySec << " s, " << lazy.memoryBytes() / (1 << 20)
+         << " MiB; assignment + route improvement " << assignSec * 1e3 << " ms, " << lazy.rowsComputed() - hot.size()
+         << " extra rows\n";
+
+    double denseBytes = (double)N * N * sizeof(float);
+    cout << "  nested vector<double> would need " << denseBytes * 2 / (1 << 30) << " GiB; flat dense "
+         << denseBytes / (1 << 30) << " GiB";
+    if (denseBytes > 2.5 * (1u << 30)) { cout << " (skipped)\n"; return; }
+    DistanceMatrix dense;
+    t0 = chrono::steady_clock::now();
+    dense.buildDense(g);
+    double denseSec = secondsSince(t0);
+    vector<Vehicle> denseFleet = vehicles;
+    shipMap.clear();
+    unassigned.clear();
+    assignShipmentsToVehicles(shipments, denseFleet, dense, shipMap, unassigned);
+    Metrics denseMetrics = evaluateSolution(denseFleet, shipMap, dense);
+    bool same = denseMetrics.totalDistance == lazyMetrics.totalDistance;
+    cout << ", built in " << denseSec << " s on " << hw << " thread(s) (" << N / denseSec << " rows/s)"
+         << (same ? "" : "  (ROUTES DIFFER)") << "\n";
+}
+
+void benchLocalSearch() {
+    const int N = 5000;
+    vector<int> sizes = {100, 300, 1000, 2000};
+    if (benchSize > 0) sizes = {(int)benchSize};
+    mt19937 rng(11);
+    Graph g = makeFreightNetwork(N, rng);
+    cout << "Route local search, " << N << "-node network, random stop order, ms (route km)\n";
+    for (int stops : sizes) {
+        vector<int> route = {(int)(rng() % N)};
+        for (int i = 1; i < stops; ++i) route.push_back(rng() % N);
+        route.push_back(route[0]);
+        vector<int> distinct = route;
+        sort(distinct.begin(), distinct.end());
+        distinct.erase(unique(distinct.begin(), distinct.end()), distinct.end());
+        DistanceMatrix dm;
+        dm.buildLazy(g, distinct.size());
+        dm.prefetch(distinct);
+
+        auto sameStops = [&](const vector<int> &r) {
+            vector<int> a(r.begin(), r.end() - 1), b(route.begin(), route.end() - 1);
+            sort(a.begin(), a.end()); sort(b.begin(), b.end());
+            return a == b && r.front() == route.front() && r.back() == route.back();
+        };
+        double start = routeDistance(route, dm);
+
+        vector<int> old200 = route;
+        auto t0 = chrono::steady_clock::now();
+        twoOptLoop(old200, dm, 200);
+        double old200Sec = secondsSince(t0);
+
+        vector<int> oldFull = route;
+        double oldFullSec = -1;
+        if (stops <= 300) {
+            t0 = chrono::steady_clock::now();
+            twoOptLoop(oldFull, dm, INT_MAX);
+            oldFullSec = secondsSince(t0);
+        }
+
+        vector<int> two = route, both = route;
+        RouteLocalSearch twoOnly(dm, {10, 0}), full(dm);
+        t0 = chrono::steady_clock::now();
+        twoOnly.optimize(two);
+        double twoSec = secondsSince(t0);
+        t0 = chrono::steady_clock::now();
+        double bestLen = full.optimize(both);
+        double fullSec = secondsSince(t0);
+
+        // Same stops as pickup/delivery pairs (1-2, 3-4, ...) of 1-6 t on a 20 t vehicle
+        vector<int> mate(route.size(), -1), paired = route;
+        vector<double> load(route.size(), 0.0);
+        for (size_t k = 1; k + 2 < route.size(); k += 2) {
+            mate[k] = k + 1;
+            mate[k + 1] = k;
+            load[k] = 1 + k % 6;
+            load[k + 1] = -load[k];
+        }
+        RouteLocalSearch pd(dm);
+        t0 = chrono::steady_clock::now();
+        double pdLen = pd.optimize(paired, mate, load, 20.0);
+        double pdSec = secondsSince(t0);
+        const vector<int> &at = pd.stopOrder();
+        vector<int> placed(route.size(), -1);
+        bool pdOk = sameStops(paired) && pdLen <= start;
+        double onboard = 0;
+        for (size_t i = 0; i < route.size() && pdOk; ++i) {
+            int k = at[i];
+            placed[k] = i;
+            onboard += load[k];
+            bool delivery = mate[k] >= 0 && mate[k] < k;
+            pdOk = paired[i] == route[k] && onboard <= 20.0 + 1e-9 && (!delivery || placed[mate[k]] >= 0);
+        }
+
+        bool ok = sameStops(old200) && sameStops(two) && sameStops(both) &&
+                  fabs(bestLen - routeDistance(both, dm)) < 1e-6 * bestLen && bestLen <= start && pdOk;
+        cout << "  " << setw(4) << stops << " stops, start " << start << " km" << (ok ? "" : "  (INVALID ROUTE)") << "\n";
+        cout << "    best-improvement 2-opt, 200 passes: " << old200Sec * 1e3 << " ms (" << routeDistance(old200, dm) << ")\n";
+        if (oldFullSec >= 0)
+            cout << "    best-improvement 2-opt, to convergence: " << oldFullSec * 1e3 << " ms (" << routeDistance(oldFull, dm) << ")\n";
+        cout << "    neighbor-list 2-opt: " << twoSec * 1e3 << " ms (" << routeDistance(two, dm) << ", "
+             << twoOnly.stats.twoOptMoves << " moves)\n";
+        cout << "    neighbor-list 2-opt + Or-opt: " << fullSec * 1e3 << " ms (" << bestLen << ", "
+             << full.stats.twoOptMoves << " + " << full.stats.orOptMoves << " moves)\n";
+        cout << "    same, pickup before delivery, 20 t: " << pdSec * 1e3 << " ms (" << pdLen << ", "
+             << pd.stats.twoOptMoves << " + " << pd.stats.orOptMoves << " moves)\n";
+    }
+}
+
+// Every shipment at most once, pickup before delivery on one vehicle, load on board within
+// capacity after every stop, routes within their shift length
+bool checkRoutePlan(const vector<Shipment> &shipments, const vector<Vehicle> &vehicles, const vector<int> &unassigned,
+                    const DistanceMatrix &distMat) {
+    unordered_map<int, const Shipment *> byId;
+    for (auto &s : shipments) byId[s.id] = &s;
+    unordered_map<int, int> seen;    // id -> 1 unassigned, 2 picked up on the current vehicle, 3 delivered
+    for (int id : unassigned) if (seen[id]++) return false;
+    for (auto &veh : vehicles) {
+        size_t m = veh.route.size();
+        if (m < 2 || veh.routeShipments.size() != m || veh.assignedShipments.size() * 2 != m - 2 ||
+            veh.route.front() != veh.depot || veh.route.back() != veh.depot)
+            return false;
+        double load = 0;
+        int carried = 0;
+        for (size_t i = 1; i + 1 < m; ++i) {
+            auto it = byId.find(veh.routeShipments[i]);
+            if (it == byId.end()) return false;
+            const Shipment &s = *it->second;
+            int &state = seen[s.id];
+            if (state == 0 && veh.route[i] == s.pickup) { state = 2; load += s.weight; ++carried; }
+            else if (state == 2 && veh.route[i] == s.delivery) { state = 3; load -= s.weight; --carried; }
+            else return false;
+            if (load > veh.capacity + 1e-9) return false;
+        }
+        if (carried != 0) return false;    // something picked up here was never delivered
+        if (veh.maxRouteKm > 0 && routeDistance(veh.route, distMat) > veh.maxRouteKm * (1 + 1e-6)) return false;
+    }
+    return seen.size() == shipments.size();
+}
+
+void benchAlns() {
+    const int N = 5000, VEHICLES = 60, SHIPMENTS = 300;
+    const double BUDGET = benchSize > 0 ? (double)benchSize : 10.0;
+    mt19937 rng(12);
+    Graph g = makeFreightNetwork(N, rng);
+    vector<Vehicle> vehicles;
+    vector<Shipment> shipments;
+    makeFreightBook(N, VEHICLES, SHIPMENTS, rng, vehicles, shipments);
+    DistanceMatrix distMat;
+    buildDistanceMatrix(distMat, g, shipments, vehicles);
+
+    vector<Vehicle> greedy = vehicles;
+    unordered_map<int, Shipment> shipMap;
+    vector<int> unassigned;
+    auto t0 = chrono::steady_clock::now();
+    assignShipmentsToVehicles(shipments, greedy, distMat, shipMap, unassigned);
+    double greedySec = secondsSince(t0);
+    Metrics gm = evaluateSolution(greedy, shipMap, distMat);
+    size_t greedyUnassigned = unassigned.size();
+
+    vector<Vehicle> fleet = vehicles;
+    shipMap.clear();
+    unassigned.clear();
+    AlnsConfig cfg;
+    cfg.timeBudgetSec = BUDGET;
+    AlnsResult res = solveWithAlns(shipments, fleet, distMat, shipMap, unassigned, cfg);
+    Metrics am = evaluateSolution(fleet, shipMap, distMat);
+    bool ok = checkRoutePlan(shipments, fleet, unassigned, distMat) && fabs(am.totalCost + unassigned.size() * cfg.unassignedPenalty - res.cost) < 1e-3 * res.cost;
+
+    cout << "ALNS, " << N << "-node network, " << VEHICLES << " vehicles, " << SHIPMENTS << " shipments, "
+         << BUDGET << " s on " << max(1u, thread::hardware_concurrency()) << " thread(s)" << (ok ? "" : "  (INFEASIBLE)") << "\n";
+    cout << "  greedy cheapest insertion: cost " << gm.totalCost << ", " << greedyUnassigned << " unassigned, "
+         << greedySec * 1e3 << " ms\n";
+    cout << "  ALNS: cost " << am.totalCost << ", distance " << res.distance << " km, " << res.unassigned << " unassigned, "
+         << res.iterations << " iterations\n";
+    cout << "  best cost over time:";
+    size_t next = 0;
+    for (double frac : {0.0, 0.01, 0.05, 0.1, 0.25, 0.5, 1.0}) {
+        while (next + 1 < res.curve.size() && res.curve[next + 1].first <= frac * BUDGET) next++;
+        cout << " " << frac * BUDGET << "s=" << res.curve[next].second;
+    }
+    cout << "\n";
+}
+
+// Cheapest pair insertion: the one-pass sweep against trying every (pickup, delivery) gap
+// pair with a stop-by-stop load check, then the full greedy assignment at fleet scale
+void benchInsertion() {
+    mt19937 rng(21);
+    cout << "Pickup/delivery insertion, sweep vs all gap pairs\n";
+    for (int stops : {40, 160, 640}) {
+        // Random route of stops / 2 shipments with loads that keep a 20 t vehicle busy
+        const int L = 400, TRIALS = 200;
+        vector<float> dist((size_t)L * L);
+        vector<pair<double,double>> xy(L);
+        for (auto &p : xy) p = {rng() % 1000, rng() % 1000};
+        for (int a = 0; a < L; ++a)
+            for (int b = 0; b < L; ++b)
+                dist[(size_t)a * L + b] = hypot(xy[a].first - xy[b].first, xy[a].second - xy[b].second);
+        auto D = [&](int a, int b) { return (double)dist[(size_t)a * L + b]; };
+        const double CAP = 20.0;
+        RouteBuild rb;
+        vector<Shipment> book;
+        while ((int)rb.nodes.size() < stops) {
+            Shipment s{(int)book.size() + 1, 1 + (int)(rng() % (L - 1)), 1 + (int)(rng() % (L - 1)), 0.5 + (rng() % 60) / 10.0, 1, 0};
+            int n = rb.nodes.size();
+            InsertionChoice c = cheapestPairInsertion(n,
+                [&](int k) { return k < 0 || k >= n ? 0 : rb.nodes[k]; },
+                [&](int k) { return rb.onboard[k]; }, CAP, s.weight, s.pickup, s.delivery, D);
+            if (c.pickGap < 0) continue;
+            // random rather than cheapest placement, so loads vary along the route
+            int i = rng() % (n + 1), j = i + rng() % (n + 1 - i);
+            bool fits = true;
+            for (int k = i - 1; k < j && fits; ++k) fits = (k < 0 ? 0.0 : rb.onboard[k]) + s.weight <= CAP;
+            book.push_back(s);
+            rb.insert(book.size() - 1, s, fits ? InsertionChoice{0.0, i, j} : c);
+        }
+        int n = rb.nodes.size();
+        auto locAt = [&](int k) { return k < 0 || k >= n ? 0 : rb.nodes[k]; };
+
+        vector<Shipment> probes;
+        for (int t = 0; t < TRIALS; ++t)
+            probes.push_back({0, 1 + (int)(rng() % (L - 1)), 1 + (int)(rng() % (L - 1)), 0.5 + (rng() % 80) / 10.0, 1, 0});
+        vector<InsertionChoice> fast(TRIALS), slow(TRIALS);
+        auto t0 = chrono::steady_clock::now();
+        for (int t = 0; t < TRIALS; ++t)
+            fast[t] = cheapestPairInsertion(n, locAt, [&](int k) { return rb.onboard[k]; }, CAP,
+                                            probes[t].weight, probes[t].pickup, probes[t].delivery, D);
+        double fastSec = secondsSince(t0);
+        t0 = chrono::steady_clock::now();
+        for (int t = 0; t < TRIALS; ++t) {
+            const Shipment &s = probes[t];
+            for (int i = 0; i <= n; ++i)
+                for (int j = i; j <= n; ++j) {
+                    bool fits = true;
+                    for (int k = i - 1; k < j && fits; ++k) fits = (k < 0 ? 0.0 : rb.onboard[k]) + s.weight <= CAP + 1e-9;
+                    if (!fits) break;    // a longer carry only adds stops
+                    int a = locAt(i - 1), b = locAt(i), c = locAt(j - 1), d = locAt(j);
+                    double delta = i == j ? D(a, s.pickup) + D(s.pickup, s.delivery) + D(s.delivery, b) - D(a, b)
+                                          : D(a, s.pickup) + D(s.pickup, b) - D(a, b) + D(c, s.delivery) + D(s.delivery, d) - D(c, d);
+                    if (delta < slow[t].delta) slow[t] = {delta, i, j};
+                }
+        }
+        double slowSec = secondsSince(t0);
+        int mismatches = 0, infeasible = 0;
+        for (int t = 0; t < TRIALS; ++t) {
+            if (slow[t].pickGap < 0) infeasible++;
+            if ((fast[t].pickGap < 0) != (slow[t].pickGap < 0) || fabs(fast[t].delta - slow[t].delta) > 1e-6 * max(1.0, slow[t].delta))
+                mismatches++;
+        }
+        cout << "  " << n << " stops (peak load " << rb.peakLoad() << "/" << CAP << "): sweep "
+             << fastSec * 1e6 / TRIALS << " us, all pairs " << slowSec * 1e6 / TRIALS << " us per shipment, "
+             << infeasible << "/" << TRIALS << " fit nowhere, " << mismatches << " mismatches\n";
+    }
+
+    const int N = 5000, VEHICLES = 500, SHIPMENTS = benchSize > 0 ? (int)benchSize : 20000;
+    // The network spans several hundred km and shipments go anywhere on it, so a shift is a
+    // multi-day tour; the limit is what spreads the book over the fleet
+    const double SHIFT_KM = 5000;
+    Graph g = makeFreightNetwork(N, rng);
+    vector<Vehicle> vehicles;
+    vector<Shipment> shipments;
+    makeFreightBook(N, VEHICLES, SHIPMENTS, rng, vehicles, shipments);
+    for (auto &veh : vehicles) veh.maxRouteKm = SHIFT_KM;
+    auto t0 = chrono::steady_clock::now();
+    DistanceMatrix distMat;
+    buildDistanceMatrix(distMat, g, shipments, vehicles);
+    double matrixSec = secondsSince(t0);
+    unordered_map<int, Shipment> shipMap;
+    vector<int> unassigned;
+    t0 = chrono::steady_clock::now();
+    assignShipmentsToVehicles(shipments, vehicles, distMat, shipMap, unassigned);
+    double assignSec = secondsSince(t0);
+    Metrics m = evaluateSolution(vehicles, shipMap, distMat);
+    double peak = 0, slack = 0, longestKm = 0;
+    size_t longest = 0;
+    for (auto &veh : vehicles) {
+        peak = max(peak, veh.peakLoad / veh.capacity);
+        slack += veh.capacity - veh.peakLoad;
+        longest = max(longest, veh.route.size());
+        longestKm = max(longestKm, routeDistance(veh.route, distMat));
+    }
+    cout << "Greedy assignment, " << N << "-node network, " << VEHICLES << " vehicles (" << SHIFT_KM << " km limit), "
+         << SHIPMENTS << " shipments"
+         << (checkRoutePlan(shipments, vehicles, unassigned, distMat) ? "" : "  (INFEASIBLE)") << "\n";
+    cout << "  distance matrix " << matrixSec << " s, assignment " << assignSec << " s\n";
+    cout << "  cost " << m.totalCost << ", distance " << m.totalDistance << " km, " << unassigned.size()
+         << " unassigned, " << m.vehiclesUsed << " vehicles used, longest route " << longest << " stops / "
+         << longestKm << " km, highest peak load " << peak * 100
+         << "% of capacity, mean spare at peak " << slack / VEHICLES << " t\n";
+    if (!unassigned.empty())
+        cout << "  " << unassigned.size() * 100.0 / SHIPMENTS << "% left unassigned: routes use "
+             << m.totalDistance * 100 / (VEHICLES * SHIFT_KM) << "% of the fleet's " << VEHICLES * SHIFT_KM
+             << " shift km, the rest of the book does not fit\n";
+}
+
+void runBenchmarks(const string &which) {
+    const vector<pair<string, function<void()>>> benches = {
+        {"matrix", benchDistanceMatrix},
+        {"localsearch", benchLocalSearch},
+        {"alns", benchAlns},
+        {"insertion", benchInsertion},
+    };
+    for (auto &b : benches)
+        if (which.empty() || which == b.first) b.second();
+}
+
 /* -------------------------
    Demo & interactive menu
    ------------------------- */
@@ -339,10 +1740,16 @@ void printVehicles(const vector<Vehicle> &v) {
     }
 }
 
-int main() {
+int main(int argc, char **argv) {
     ios::sync_with_stdio(false);
     cin.tie(nullptr);
 
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        if (argc > 3) benchSize = atoll(argv[3]);
+        runBenchmarks(argc > 2 ? argv[2] : "");
+        return 0;
+    }
+
     cout << "=== Industrial Goods Transport Optimization Demo ===\n\n";
 
     // Build a sample graph (nodes 0..6)
@@ -358,9 +1765,6 @@ int main() {
 
     printGraph(g);
 
-    // Precompute all-pairs shortest distances
-    auto distMat = allPairsShortest(g);
-
     // Example shipments
     vector<Shipment> shipments = {
         {1, 0, 4, 2.5, 10, 8.0},
@@ -379,8 +1783,15 @@ int main() {
         {2, 1, 6.0, 1.2, 0.20},
         {3, 2, 10.0, 1.7, 0.30}
     };
+    // Route length each vehicle can drive in one shift (km). Without a limit the cheapest
+    // vehicle per km would take the whole book on one long tour.
+    for (auto &veh : vehicles) veh.maxRouteKm = 90;
     printVehicles(vehicles);
 
+    // Shortest distances between every node routing can visit
+    DistanceMatrix distMat;
+    buildDistanceMatrix(distMat, g, shipments, vehicles);
+
     // Run assignment
     unordered_map<int, Shipment> shipMap;
     vector<int> unassigned;
@@ -392,7 +1803,8 @@ int main() {
     // Print vehicle routes & assignment
     cout << "\n--- Assignment & Routes ---\n";
     for (auto &veh : vehicles) {
-        cout << "Vehicle " << veh.id << " depot " << veh.depot << " capacity " << veh.capacity << " assigned load " << veh.loadAssigned << "\n";
+        cout << "Vehicle " << veh.id << " depot " << veh.depot << " capacity " << veh.capacity << " assigned load " << veh.loadAssigned
+             << " (peak on board " << veh.peakLoad << ")\n";
         cout << "  Shipments: ";
         for (int sid : veh.assignedShipments) cout << sid << " ";
         cout << "\n  Route: ";
@@ -421,16 +1833,35 @@ int main() {
     // Simple what-if: add new vehicle and re-run assignment
     cout << "\n--- What-if: add a new larger vehicle to reduce unassigned ---\n";
     vehicles.push_back({4, 0, 12.0, 1.6, 0.28});
+    vehicles.back().maxRouteKm = 120;    // a truck on a longer shift
     unassigned.clear(); shipMap.clear();
     assignShipmentsToVehicles(shipments, vehicles, distMat, shipMap, unassigned);
     metrics = evaluateSolution(vehicles, shipMap, distMat);
     cout << "After adding vehicle 4:\n";
     for (auto &veh : vehicles) {
-        cout << "V" << veh.id << " assigned " << veh.assignedShipments.size() << " shipments, load " << veh.loadAssigned << "\n";
+        cout << "V" << veh.id << " assigned " << veh.assignedShipments.size() << " shipments, load " << veh.loadAssigned << ", peak " << veh.peakLoad << "\n";
     }
     cout << "Unassigned now: " << unassigned.size() << "\n";
 
-    cout << "\nDemo complete. You can extend:\n- time windows, split deliveries, dynamic rebalancing,\n- vehicle return-to-depot scheduling optimization,\n- richer VRP metaheuristics (simulated annealing, Tabu, Clarke-Wright)\n- real road network import and real distances.\n";
+    // Same fleet, solved by ALNS with pickup-before-delivery routes
+    cout << "\n--- ALNS (0.5 s budget, pickup before delivery) ---\n";
+    AlnsConfig alnsCfg;
+    alnsCfg.timeBudgetSec = 0.5;
+    unassigned.clear(); shipMap.clear();
+    AlnsResult alns = solveWithAlns(shipments, vehicles, distMat, shipMap, unassigned, alnsCfg);
+    metrics = evaluateSolution(vehicles, shipMap, distMat);
+    for (auto &veh : vehicles) {
+        cout << "V" << veh.id << " load " << veh.loadAssigned << " (peak " << veh.peakLoad << "/" << veh.capacity << ") route: ";
+        for (int node : veh.route) cout << node << " ";
+        cout << "(" << routeDistance(veh.route, distMat) << " km)\n";
+    }
+    cout << "Total distance (km): " << metrics.totalDistance << ", cost: " << metrics.totalCost
+         << ", unassigned: " << unassigned.size() << ", iterations: " << alns.iterations << "\n";
+    cout << "Best cost over time:";
+    for (auto &point : alns.curve) cout << " " << point.first << "s=" << point.second;
+    cout << "\n";
+
+    cout << "\nDemo complete. You can extend:\n- time windows, split deliveries, dynamic rebalancing,\n- vehicle return-to-depot scheduling optimization,\n- Tabu search or Clarke-Wright savings as ALNS starting points\n- real road network import and real distances.\n";
 
     return 0;
 }
@@ -4,7 +4,7 @@ using namespace std;
 /*==========================================
             KMP PATTERN SEARCH
 ===========================================*/
-vector<int> buildLPS(string pat) {
+vector<int> buildLPS(const string &pat) {
     int n = pat.size();
     vector<int> lps(n, 0);
     int len = 0, i = 1;
@@ -20,7 +20,7 @@ vector<int> buildLPS(string pat) {
     return lps;
 }
 
-bool KMP_Search(string text, string pat) {
+bool KMP_Search(const string &text, const string &pat) {
     vector<int> lps = buildLPS(pat);
     int i = 0, j = 0;
 
@@ -36,31 +36,290 @@ bool KMP_Search(string text, string pat) {
 }
 
 /*==========================================
-            HASH TABLE FOR EMERGENCY TYPE
+     KEYWORD TABLE FOR EMERGENCY TYPE
 ===========================================*/
-unordered_map<string, int> emergencyLevel = {
+struct AlertKeyword {
+    const char *word;
+    int severity;
+};
+
+// Compile-time keyword -> severity table (bit i of a match mask = ALERT_KEYWORDS[i])
+constexpr AlertKeyword ALERT_KEYWORDS[] = {
     {"FIRE", 10},
     {"EARTHQUAKE", 9},
     {"FLOOD", 8},
     {"MEDICAL", 7},
     {"ACCIDENT", 6}
 };
+constexpr int ALERT_KEYWORD_COUNT = sizeof(ALERT_KEYWORDS) / sizeof(ALERT_KEYWORDS[0]);
+
+constexpr int cstrLength(const char *s) {
+    int n = 0;
+    while (s[n]) n++;
+    return n;
+}
+
+constexpr int alertTrieSize() {
+    int n = 1; // root
+    for (int k = 0; k < ALERT_KEYWORD_COUNT; k++) n += cstrLength(ALERT_KEYWORDS[k].word);
+    return n;
+}
+
+/*==========================================
+   AHO-CORASICK AUTOMATON (BUILT AT COMPILE TIME)
+===========================================*/
+// Every keyword is matched in one left-to-right pass over the message.
+// Bytes are folded into a handful of character classes (one per distinct
+// keyword letter + "other"), so the full DFA is only states x classes bytes.
+struct AlertAutomaton {
+    static constexpr int MAX_STATES = alertTrieSize();
+    static constexpr int MAX_CLASSES = 64;
+
+    uint8_t charClass[256] = {};
+    int numClasses = 1;                          // class 0 = byte not in any keyword
+    int numStates = 1;
+    uint8_t next[MAX_STATES][MAX_CLASSES] = {};  // full transition table (no fail walks at runtime)
+    uint8_t severity[MAX_STATES] = {};           // max severity of keywords ending in this state
+    uint32_t mask[MAX_STATES] = {};              // which keywords end in this state
+
+    constexpr AlertAutomaton() {
+        static_assert(MAX_STATES <= 256, "alert automaton states must fit in uint8_t");
+        static_assert(ALERT_KEYWORD_COUNT <= 32, "alert keyword mask is 32 bits");
+
+        for (int k = 0; k < ALERT_KEYWORD_COUNT; k++)
+            for (const char *c = ALERT_KEYWORDS[k].word; *c; c++) {
+                unsigned char b = (unsigned char)*c;
+                if (charClass[b] == 0) charClass[b] = (uint8_t)numClasses++;
+            }
+
+        // Trie: 0 in next[][] means "no child" while building (root is never a child)
+        for (int k = 0; k < ALERT_KEYWORD_COUNT; k++) {
+            int s = 0;
+            for (const char *c = ALERT_KEYWORDS[k].word; *c; c++) {
+                int cls = charClass[(unsigned char)*c];
+                if (next[s][cls] == 0) next[s][cls] = (uint8_t)numStates++;
+                s = next[s][cls];
+            }
+            mask[s] |= 1u << k;
+            if (ALERT_KEYWORDS[k].severity > severity[s]) severity[s] = (uint8_t)ALERT_KEYWORDS[k].severity;
+        }
+
+        // BFS over the trie turns it into a DFA and merges outputs along fail links
+        int fail[MAX_STATES] = {};
+        int queue[MAX_STATES] = {};
+        int head = 0, tail = 0;
+        for (int cls = 0; cls < numClasses; cls++) {
+            int child = next[0][cls];
+            if (child) { fail[child] = 0; queue[tail++] = child; }
+        }
+        while (head < tail) {
+            int s = queue[head++];
+            mask[s] |= mask[fail[s]];
+            if (severity[fail[s]] > severity[s]) severity[s] = severity[fail[s]];
+            for (int cls = 0; cls < numClasses; cls++) {
+                int child = next[s][cls];
+                if (child) {
+                    fail[child] = next[fail[s]][cls];
+                    queue[tail++] = child;
+                } else {
+                    next[s][cls] = next[fail[s]][cls];
+                }
+            }
+        }
+    }
+};
+
+constexpr AlertAutomaton ALERT_DFA{};
+
+/*==========================================
+        SINGLE-PASS ALERT CLASSIFIER
+===========================================*/
+struct AlertClass {
+    int severity;   // 0 = no emergency keyword found
+    uint32_t mask;  // bit i set => ALERT_KEYWORDS[i] occurs in the message
+};
+
+inline AlertClass classifyAlert(string_view msg) {
+    const AlertAutomaton &dfa = ALERT_DFA;
+    unsigned s = 0, sev = 0;
+    uint32_t mask = 0;
+    for (unsigned char c : msg) {
+        s = dfa.next[s][dfa.charClass[c]];
+        sev = max(sev, (unsigned)dfa.severity[s]);
+        mask |= dfa.mask[s];
+    }
+    return {(int)sev, mask};
+}
+
+// Batch API: classifies msgs[i] into out[i]; returns how many carried a keyword
+size_t classifyAlertBatch(const vector<string_view> &msgs, vector<AlertClass> &out) {
+    out.resize(msgs.size());
+    size_t hits = 0;
+    for (size_t i = 0; i < msgs.size(); i++) {
+        out[i] = classifyAlert(msgs[i]);
+        hits += out[i].mask != 0;
+    }
+    return hits;
+}
+
+struct ClassifiedMessage {
+    string id;
+    AlertClass cls;
+};
+
+// Batch API over "message_id,content" CSV files (e.g. datasets/case09_alert_messages.csv).
+// The whole file is read once and messages are classified straight out of the buffer.
+bool classifyAlertFile(const string &path, vector<ClassifiedMessage> &out) {
+    ifstream in(path, ios::binary);
+    if (!in) return false;
+    string buf((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+
+    string_view data(buf);
+    bool header = true;
+    while (!data.empty()) {
+        size_t eol = data.find('\n');
+        string_view line = data.substr(0, eol);
+        data = (eol == string_view::npos) ? string_view() : data.substr(eol + 1);
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        if (header) { header = false; continue; }
+        if (line.empty()) continue;
+
+        size_t comma = line.find(',');
+        string_view id = line.substr(0, comma);
+        string_view content = (comma == string_view::npos) ? string_view() : line.substr(comma + 1);
+        out.push_back({string(id), classifyAlert(content)});
+    }
+    return true;
+}
 
 /*==========================================
-          PRIORITY QUEUE (MAX-HEAP)
+      BUCKETED SEVERITY QUEUE (O(1) PUSH/POP-MAX)
 ===========================================*/
 struct Alert {
     int severity;
     string message;
 };
 
-struct Compare {
-    bool operator()(Alert const &a, Alert const &b) {
-        return a.severity < b.severity; // Max-Heap
+// Intrusive Vyukov MPSC queue: any number of producers, one consumer.
+// push is a single atomic exchange; FIFO in the order producers linearise.
+template<typename T>
+class MPSCQueue {
+    struct Node {
+        atomic<Node*> next{nullptr};
+        T value;
+        int64_t enqueuedNs = 0;
+    };
+    alignas(64) atomic<Node*> tail;
+    alignas(64) Node *head;   // consumer-owned
+public:
+    MPSCQueue() { head = new Node(); tail.store(head, memory_order_relaxed); }
+    ~MPSCQueue() {
+        while (head) { Node *n = head->next.load(memory_order_relaxed); delete head; head = n; }
+    }
+    MPSCQueue(const MPSCQueue&) = delete;
+    MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+    void push(T v, int64_t nowNs) {
+        Node *n = new Node();
+        n->value = move(v);
+        n->enqueuedNs = nowNs;
+        Node *prev = tail.exchange(n, memory_order_acq_rel);
+        prev->next.store(n, memory_order_release);
     }
+    // Returns false if empty (or a producer is mid-push; caller retries later)
+    bool pop(T &out, int64_t &enqueuedNs) {
+        Node *nxt = head->next.load(memory_order_acquire);
+        if (!nxt) return false;
+        out = move(nxt->value);
+        enqueuedNs = nxt->enqueuedNs;
+        delete head;
+        head = nxt;   // nxt becomes the new stub
+        return true;
+    }
+};
+
+struct SeverityStats {
+    int severity;
+    long long depth;          // alerts currently waiting
+    unsigned long long popped;
+    double avgDwellUs;        // enqueue -> pop latency
+    double maxDwellUs;
 };
 
-priority_queue<Alert, vector<Alert>, Compare> alertHeap;
+// Radix/bucket priority queue for bounded integer severities [MIN_SEV, MAX_SEV].
+// One MPSC queue per severity keeps equal-severity alerts in arrival order;
+// a non-empty bitmask makes pop-max a single count-leading-zeros.
+// push() is safe from many sensor threads; popMax() must stay on one thread.
+template<typename T, int MIN_SEV, int MAX_SEV>
+class SeverityQueue {
+    static constexpr int LEVELS = MAX_SEV - MIN_SEV + 1;
+    static_assert(LEVELS > 0 && LEVELS <= 32, "severity range must fit a 32-bit mask");
+
+    struct alignas(64) Bucket {
+        MPSCQueue<T> q;
+        atomic<long long> depth{0};
+        atomic<unsigned long long> popped{0};
+        atomic<long long> dwellNsTotal{0};
+        atomic<long long> dwellNsMax{0};
+    };
+    Bucket buckets[LEVELS];
+    alignas(64) atomic<uint32_t> nonEmpty{0};
+
+    static int64_t nowNs() {
+        return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    static int level(int severity) { return min(max(severity, MIN_SEV), MAX_SEV) - MIN_SEV; }
+public:
+    void push(T v) {
+        int b = level(v.severity);
+        buckets[b].q.push(move(v), nowNs());
+        buckets[b].depth.fetch_add(1, memory_order_release);
+        nonEmpty.fetch_or(1u << b, memory_order_release);
+    }
+
+    bool popMax(T &out) {
+        uint32_t bits = nonEmpty.load(memory_order_acquire);
+        while (bits) {
+            int b = 31 - __builtin_clz(bits);
+            Bucket &bk = buckets[b];
+            int64_t enq;
+            if (bk.q.pop(out, enq)) {
+                long long dwell = nowNs() - enq;
+                bk.popped.fetch_add(1, memory_order_relaxed);
+                bk.dwellNsTotal.fetch_add(dwell, memory_order_relaxed);
+                if (dwell > bk.dwellNsMax.load(memory_order_relaxed)) bk.dwellNsMax.store(dwell, memory_order_relaxed);
+                if (bk.depth.fetch_sub(1, memory_order_acq_rel) == 1) clearIfDrained(b);
+                return true;
+            }
+            clearIfDrained(b);
+            bits &= ~(1u << b);
+        }
+        return false;
+    }
+
+    bool empty() const { return nonEmpty.load(memory_order_acquire) == 0; }
+
+    vector<SeverityStats> stats() const {
+        vector<SeverityStats> out;
+        for (int b = LEVELS - 1; b >= 0; b--) {
+            const Bucket &bk = buckets[b];
+            unsigned long long n = bk.popped.load(memory_order_relaxed);
+            out.push_back({b + MIN_SEV, max(0LL, bk.depth.load(memory_order_relaxed)), n,
+                           n ? bk.dwellNsTotal.load(memory_order_relaxed) / 1e3 / n : 0.0,
+                           bk.dwellNsMax.load(memory_order_relaxed) / 1e3});
+        }
+        return out;
+    }
+private:
+    // Clear the bucket bit, then re-set it if a producer slipped in meanwhile
+    void clearIfDrained(int b) {
+        nonEmpty.fetch_and(~(1u << b), memory_order_acq_rel);
+        if (buckets[b].depth.load(memory_order_acquire) > 0)
+            nonEmpty.fetch_or(1u << b, memory_order_release);
+    }
+};
+
+SeverityQueue<Alert, 1, 10> alertQueue;
 
 /*==========================================
          BFS SAFE ZONE CHECK
@@ -115,19 +374,631 @@ vector<int> dijkstra(vector<vector<pair<int,int>>> &graph, int src) {
     return dist;
 }
 
+/*==========================================
+     ALL-EXITS EVACUATION FIELD
+===========================================*/
+struct Corridor {
+    int to;
+    int time;      // traversal time
+    int capacity;  // people the corridor can carry during the evacuation window
+};
+
+using BuildingGraph = vector<vector<Corridor>>;
+
+struct EvacuationField {
+    vector<int> dist;         // time to nearest exit (INT_MAX = trapped)
+    vector<int> nextHop;      // next node towards that exit (-1 at exits / trapped)
+    vector<int> nearestExit;  // exit node reached by following nextHop (-1 = trapped)
+};
+
+// One multi-source Dijkstra from every exit over reversed corridors.
+// Afterwards any occupant's exit, time and next step are O(1) lookups.
+EvacuationField buildEvacuationField(const BuildingGraph &g, const vector<int> &exits) {
+    int n = g.size();
+
+    // Reverse graph in CSR form: for corridor u -> v store u in v's row
+    vector<int> start(n + 1, 0);
+    for (int u = 0; u < n; u++)
+        for (auto &c : g[u]) start[c.to + 1]++;
+    for (int v = 0; v < n; v++) start[v + 1] += start[v];
+    vector<int> revFrom(start[n]), revTime(start[n]);
+    vector<int> fill(start.begin(), start.end() - 1);
+    for (int u = 0; u < n; u++)
+        for (auto &c : g[u]) {
+            int k = fill[c.to]++;
+            revFrom[k] = u;
+            revTime[k] = c.time;
+        }
+
+    EvacuationField f;
+    f.dist.assign(n, INT_MAX);
+    f.nextHop.assign(n, -1);
+    f.nearestExit.assign(n, -1);
+
+    priority_queue<pair<int,int>, vector<pair<int,int>>, greater<>> pq;
+    for (int e : exits) {
+        f.dist[e] = 0;
+        f.nearestExit[e] = e;
+        pq.push({0, e});
+    }
+
+    while (!pq.empty()) {
+        auto [d, v] = pq.top(); pq.pop();
+        if (d > f.dist[v]) continue;
+
+        for (int k = start[v]; k < start[v + 1]; k++) {
+            int u = revFrom[k];
+            int nd = d + revTime[k];
+            if (nd < f.dist[u]) {
+                f.dist[u] = nd;
+                f.nextHop[u] = v;
+                f.nearestExit[u] = f.nearestExit[v];
+                pq.push({nd, u});
+            }
+        }
+    }
+    return f;
+}
+
+/*==========================================
+   CAPACITY-AWARE EVACUATION (MIN-COST FLOW)
+===========================================*/
+struct EvacGroup {
+    int from;
+    int exit;
+    int people;
+    int time;   // corridor time of the path this group takes
+};
+
+struct CrowdAssignment {
+    long long evacuated = 0;
+    long long stranded = 0;          // could not leave without overloading a corridor / exit
+    long long totalPersonTime = 0;   // sum over people of their path time
+    int latestArrival = 0;
+    vector<long long> exitLoad;      // parallel to the exits argument
+    vector<EvacGroup> groups;
+};
+
+// Primal-dual min-cost flow: super source -> occupied nodes -> corridors -> exits -> sink.
+// Each Dijkstra (on reduced costs) is followed by repeated DFS augmentation over
+// the zero-reduced-cost edges, so equal-time paths are saturated in one phase.
+class EvacuationFlow {
+    struct FlowEdge { int to, cap, cost; };
+    vector<FlowEdge> edges;          // edge k and k^1 are a residual pair
+    vector<vector<int>> adj;
+    int n, S, T;
+
+    int addEdge(int u, int v, int cap, int cost) {
+        adj[u].push_back(edges.size()); edges.push_back({v, cap, cost});
+        adj[v].push_back(edges.size()); edges.push_back({u, 0, -cost});
+        return (int)edges.size() - 2;
+    }
+public:
+    CrowdAssignment solve(const BuildingGraph &g, const vector<int> &occupants,
+                          const vector<int> &exits, const vector<int> &exitCapacity) {
+        n = g.size(); S = n; T = n + 1;
+        edges.clear();
+        adj.assign(n + 2, {});
+
+        vector<int> corridorEdges;
+        for (int u = 0; u < n; u++)
+            for (auto &c : g[u]) corridorEdges.push_back(addEdge(u, c.to, c.capacity, c.time));
+        long long people = 0;
+        for (int u = 0; u < n; u++)
+            if (occupants[u] > 0) { addEdge(S, u, occupants[u], 0); people += occupants[u]; }
+        vector<int> exitEdges;
+        for (size_t i = 0; i < exits.size(); i++)
+            exitEdges.push_back(addEdge(exits[i], T, exitCapacity[i], 0));
+
+        const long long INF = LLONG_MAX / 4;
+        vector<long long> pot(n + 2, 0), dist(n + 2);
+        vector<int> state(n + 2), iter(n + 2);
+        CrowdAssignment res;
+
+        while (true) {
+            // Shortest paths on reduced costs (all >= 0 thanks to the potentials)
+            fill(dist.begin(), dist.end(), INF);
+            priority_queue<pair<long long,int>, vector<pair<long long,int>>, greater<>> pq;
+            dist[S] = 0; pq.push({0, S});
+            while (!pq.empty()) {
+                auto [d, u] = pq.top(); pq.pop();
+                if (d > dist[u]) continue;
+                if (u == T) break;   // nodes farther than T get pot += dist[T] below
+                for (int k : adj[u]) {
+                    const FlowEdge &e = edges[k];
+                    if (e.cap <= 0) continue;
+                    long long nd = d + e.cost + pot[u] - pot[e.to];
+                    if (nd < dist[e.to]) { dist[e.to] = nd; pq.push({nd, e.to}); }
+                }
+            }
+            if (dist[T] >= INF) break;
+            for (int v = 0; v < n + 2; v++) pot[v] += min(dist[v], dist[T]);
+
+            // Augment along admissible (zero reduced cost) residual edges until none is left.
+            // state: 0 = unseen, 1 = on current DFS path, 2 = dead end for this phase
+            auto admissible = [&](int u, const FlowEdge &e) {
+                return e.cap > 0 && e.cost + pot[u] - pot[e.to] == 0;
+            };
+            fill(state.begin(), state.end(), 0);
+            fill(iter.begin(), iter.end(), 0);
+            vector<int> path;
+            int u = S;
+            state[S] = 1;
+            while (true) {
+                if (u == T) {
+                    int push = INT_MAX;
+                    for (int k : path) push = min(push, edges[k].cap);
+                    for (int k : path) { edges[k].cap -= push; edges[k ^ 1].cap += push; state[edges[k].to] = 0; }
+                    res.evacuated += push;
+                    res.totalPersonTime += (long long)push * (pot[T] - pot[S]);
+                    path.clear(); u = S;
+                    continue;
+                }
+                bool advanced = false;
+                for (int &i = iter[u]; i < (int)adj[u].size(); i++) {
+                    int k = adj[u][i];
+                    const FlowEdge &e = edges[k];
+                    if (state[e.to] == 0 && admissible(u, e)) {
+                        path.push_back(k); u = e.to; state[u] = 1; advanced = true;
+                        break;
+                    }
+                }
+                if (advanced) continue;
+                if (u == S) break;
+                state[u] = 2;   // dead end, retreat
+                int k = path.back(); path.pop_back();
+                u = edges[k ^ 1].to;
+            }
+        }
+        res.stranded = people - res.evacuated;
+
+        for (int k : exitEdges) res.exitLoad.push_back(edges[k ^ 1].cap);
+
+        // Decompose corridor flow into (origin, exit, people) groups
+        vector<int> flowLeft(edges.size(), 0);
+        for (int k : corridorEdges) flowLeft[k] = edges[k ^ 1].cap;
+        vector<int> exitIndex(n, -1);
+        for (size_t i = 0; i < exits.size(); i++) exitIndex[exits[i]] = i;
+        vector<int> exitLeft(res.exitLoad.begin(), res.exitLoad.end());
+        vector<int> ptr(n, 0);
+        for (int k : adj[S]) {
+            if (k & 1) continue;
+            int src = edges[k].to, remaining = edges[k ^ 1].cap;
+            while (remaining > 0) {
+                vector<int> path;
+                int u = src, push = remaining;
+                while (exitIndex[u] < 0 || exitLeft[exitIndex[u]] == 0) {
+                    int &i = ptr[u];
+                    while (i < (int)adj[u].size() && flowLeft[adj[u][i]] == 0) i++;
+                    if (i == (int)adj[u].size()) break;
+                    int e = adj[u][i];
+                    path.push_back(e);
+                    push = min(push, flowLeft[e]);
+                    u = edges[e].to;
+                }
+                if (exitIndex[u] < 0) break;   // should not happen: flow is conserved
+                push = min(push, exitLeft[exitIndex[u]]);
+                int t = 0;
+                for (int e : path) { flowLeft[e] -= push; t += edges[e].cost; }
+                exitLeft[exitIndex[u]] -= push;
+                remaining -= push;
+                res.latestArrival = max(res.latestArrival, t);
+                res.groups.push_back({src, u, push, t});
+            }
+        }
+        return res;
+    }
+};
+
+/*==========================================
+     HAZARD-AWARE INCREMENTAL RE-ROUTING
+===========================================*/
+struct HazardTickStats {
+    int newlyBlocked = 0;
+    int affectedNodes = 0;        // nodes whose route to an exit had to be repaired
+    int reroutedOccupants = 0;
+    int caughtOccupants = 0;      // occupants standing on a node the hazard just reached
+    int trappedOccupants = 0;     // no exit reachable any more
+    double micros = 0;
+};
+
+// Keeps the all-exits evacuation field valid while hazards block nodes.
+// Blocking only lengthens distances, so only nodes whose next-hop chain runs
+// through a blocked node need repair: that subtree is invalidated, re-seeded
+// from its intact neighbours, and settled with a Dijkstra confined to it.
+class HazardRouter {
+    int n;
+    vector<int> fwdStart, fwdTo, fwdTime;   // forward CSR
+    vector<int> revStart, revFrom, revTime; // reverse CSR
+    vector<int> exits;
+    EvacuationField field;
+    vector<char> blocked, affected, queued;
+    vector<int> front;                      // hazard front for the next spread step
+    vector<int> occupantPos;                // -1 = evacuated or caught
+    vector<int> crowd;                      // occupants per node
+
+    static void buildCSR(int n, const vector<array<int,3>> &arcs, vector<int> &start, vector<int> &to, vector<int> &w) {
+        start.assign(n + 1, 0);
+        for (auto &a : arcs) start[a[0] + 1]++;
+        for (int i = 0; i < n; i++) start[i + 1] += start[i];
+        to.resize(arcs.size()); w.resize(arcs.size());
+        vector<int> fill(start.begin(), start.end() - 1);
+        for (auto &a : arcs) { int k = fill[a[0]]++; to[k] = a[1]; w[k] = a[2]; }
+    }
+public:
+    HazardRouter(const BuildingGraph &g, const vector<int> &exitNodes, const vector<int> &occupantNodes)
+        : n(g.size()), exits(exitNodes), blocked(n, 0), affected(n, 0), queued(n, 0),
+          occupantPos(occupantNodes), crowd(n, 0) {
+        vector<array<int,3>> fwd, rev;
+        for (int u = 0; u < n; u++)
+            for (auto &c : g[u]) { fwd.push_back({u, c.to, c.time}); rev.push_back({c.to, u, c.time}); }
+        buildCSR(n, fwd, fwdStart, fwdTo, fwdTime);
+        buildCSR(n, rev, revStart, revFrom, revTime);
+        field = buildEvacuationField(g, exits);
+        for (int p : occupantPos) crowd[p]++;
+    }
+
+    const EvacuationField &evacuationField() const { return field; }
+    bool isBlocked(int v) const { return blocked[v]; }
+
+    // Seed hazard sources (fire / flood origins); they burn on the next spread step
+    void ignite(const vector<int> &sources) {
+        for (int s : sources) if (!queued[s] && !blocked[s]) { queued[s] = 1; front.push_back(s); }
+    }
+
+    // Hazard advances one BFS layer: the current front burns, its neighbours become the next front
+    HazardTickStats spreadHazard() {
+        vector<int> burning;
+        burning.swap(front);
+        for (int u : burning)
+            for (int k = fwdStart[u]; k < fwdStart[u + 1]; k++) {
+                int v = fwdTo[k];
+                if (!queued[v] && !blocked[v]) { queued[v] = 1; front.push_back(v); }
+            }
+        return blockNodes(burning);
+    }
+
+    HazardTickStats blockNodes(const vector<int> &nodes) {
+        auto t0 = chrono::steady_clock::now();
+        HazardTickStats st;
+
+        // 1. Invalidate blocked nodes and every node routed through them
+        vector<int> region;
+        for (int v : nodes) {
+            if (blocked[v]) continue;
+            blocked[v] = 1;
+            st.newlyBlocked++;
+            st.caughtOccupants += crowd[v];
+            if (!affected[v]) { affected[v] = 1; region.push_back(v); }
+        }
+        for (size_t i = 0; i < region.size(); i++) {
+            int x = region[i];
+            for (int k = revStart[x]; k < revStart[x + 1]; k++) {
+                int u = revFrom[k];
+                if (!affected[u] && field.nextHop[u] == x) { affected[u] = 1; region.push_back(u); }
+            }
+        }
+
+        // 2. Re-seed the region from intact neighbours outside it
+        priority_queue<pair<int,int>, vector<pair<int,int>>, greater<>> pq;
+        for (int u : region) {
+            field.dist[u] = INT_MAX;
+            field.nextHop[u] = -1;
+            field.nearestExit[u] = -1;
+            if (blocked[u]) continue;
+            for (int k = fwdStart[u]; k < fwdStart[u + 1]; k++) {
+                int v = fwdTo[k];
+                if (affected[v] || blocked[v] || field.dist[v] == INT_MAX) continue;
+                int nd = field.dist[v] + fwdTime[k];
+                if (nd < field.dist[u]) {
+                    field.dist[u] = nd;
+                    field.nextHop[u] = v;
+                    field.nearestExit[u] = field.nearestExit[v];
+                }
+            }
+            if (field.dist[u] != INT_MAX) pq.push({field.dist[u], u});
+        }
+
+        // 3. Dijkstra confined to the region
+        while (!pq.empty()) {
+            auto [d, v] = pq.top(); pq.pop();
+            if (d > field.dist[v]) continue;
+            for (int k = revStart[v]; k < revStart[v + 1]; k++) {
+                int u = revFrom[k];
+                if (!affected[u] || blocked[u]) continue;
+                int nd = d + revTime[k];
+                if (nd < field.dist[u]) {
+                    field.dist[u] = nd;
+                    field.nextHop[u] = v;
+                    field.nearestExit[u] = field.nearestExit[v];
+                    pq.push({nd, u});
+                }
+            }
+        }
+
+        for (int u : region) {
+            if (!blocked[u]) {
+                st.reroutedOccupants += crowd[u];
+                if (field.dist[u] == INT_MAX) st.trappedOccupants += crowd[u];
+            }
+            affected[u] = 0;
+        }
+        st.affectedNodes = region.size();
+
+        // Occupants on burning nodes are lost to the hazard
+        for (int v : nodes) crowd[v] = 0;
+        if (st.caughtOccupants > 0)
+            for (int &p : occupantPos) if (p >= 0 && blocked[p]) p = -1;
+
+        st.micros = chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count();
+        return st;
+    }
+
+    // Every remaining occupant takes one step along its (possibly repaired) route
+    int moveOccupants() {
+        int arrived = 0;
+        for (int &p : occupantPos) {
+            if (p < 0) continue;
+            if (field.nearestExit[p] == p) { crowd[p]--; p = -1; arrived++; continue; }
+            int nxt = field.nextHop[p];
+            if (nxt < 0) continue;   // trapped: stay put
+            crowd[p]--; crowd[nxt]++; p = nxt;
+        }
+        return arrived;
+    }
+
+    // Reference: full multi-source Dijkstra ignoring blocked nodes (for validation / benchmarks)
+    EvacuationField recomputeFromScratch() const {
+        EvacuationField f;
+        f.dist.assign(n, INT_MAX); f.nextHop.assign(n, -1); f.nearestExit.assign(n, -1);
+        priority_queue<pair<int,int>, vector<pair<int,int>>, greater<>> pq;
+        for (int e : exits) if (!blocked[e]) { f.dist[e] = 0; f.nearestExit[e] = e; pq.push({0, e}); }
+        while (!pq.empty()) {
+            auto [d, v] = pq.top(); pq.pop();
+            if (d > f.dist[v]) continue;
+            for (int k = revStart[v]; k < revStart[v + 1]; k++) {
+                int u = revFrom[k];
+                if (blocked[u]) continue;
+                int nd = d + revTime[k];
+                if (nd < f.dist[u]) { f.dist[u] = nd; f.nextHop[u] = v; f.nearestExit[u] = f.nearestExit[v]; pq.push({nd, u}); }
+            }
+        }
+        return f;
+    }
+};
+
+/*==========================================
+                 BENCHMARKS
+===========================================*/
+// Run with: ./acase7 --bench
+void benchmarkAlertClassifier(int messages) {
+    const vector<string> fragments = {
+        "Smoke detected! Possible FIRE in Block A.", "ALL_CLEAR_SIGNAL", "EMERGENCY_EXIT_OPEN",
+        "EMERGENCY_FIRE_ALERT", "Minor EARTHQUAKE tremor, FLOOD risk in basement",
+        "MEDICAL team requested at gate 3", "Routine patrol, nothing to report",
+        "ACCIDENT reported near parking level 2", "Water leak near FLOODgate sensor 17"
+    };
+    mt19937 rng(7);
+    vector<string> msgs(messages);
+    for (auto &m : msgs) m = fragments[rng() % fragments.size()] + " #" + to_string(rng() % 100000);
+
+    auto t0 = chrono::steady_clock::now();
+    long long kmpChecksum = 0;
+    for (const string &m : msgs) {
+        int best = 0;
+        for (int k = 0; k < ALERT_KEYWORD_COUNT; k++)
+            if (KMP_Search(m, ALERT_KEYWORDS[k].word)) best = max(best, ALERT_KEYWORDS[k].severity);
+        kmpChecksum += best;
+    }
+    auto t1 = chrono::steady_clock::now();
+
+    vector<string_view> views(msgs.begin(), msgs.end());
+    vector<AlertClass> out;
+    classifyAlertBatch(views, out);
+    auto t2 = chrono::steady_clock::now();
+    long long dfaChecksum = 0;
+    for (auto &c : out) dfaChecksum += c.severity;
+
+    double kmpSec = chrono::duration<double>(t1 - t0).count();
+    double dfaSec = chrono::duration<double>(t2 - t1).count();
+    cout << "Alert classifier, " << messages << " messages\n";
+    cout << "  KMP per keyword : " << kmpSec * 1e3 << " ms (" << messages / kmpSec / 1e6 << " M msg/s)\n";
+    cout << "  single-pass DFA : " << dfaSec * 1e3 << " ms (" << messages / dfaSec / 1e6 << " M msg/s)\n";
+    cout << "  results " << (kmpChecksum == dfaChecksum ? "match" : "DIFFER") << "\n";
+}
+
+struct SensorAlert {
+    int severity;
+    int producer;
+    int seq;
+};
+
+// Many sensor threads push while one dispatcher drains; checks FIFO per severity
+void benchmarkSeverityQueue(int producers, int perProducer) {
+    SeverityQueue<SensorAlert, 1, 10> q;
+    atomic<int> running{producers};
+    vector<thread> threads;
+    auto t0 = chrono::steady_clock::now();
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&, p] {
+            mt19937 rng(p + 1);
+            for (int i = 0; i < perProducer; i++) q.push({5 + (int)(rng() % 6), p, i});
+            running.fetch_sub(1);
+        });
+    }
+
+    long long total = (long long)producers * perProducer, got = 0;
+    bool fifoOk = true;
+    vector<vector<int>> lastSeq(11, vector<int>(producers, -1));
+    SensorAlert a;
+    while (got < total) {
+        if (q.popMax(a)) {
+            got++;
+            int &last = lastSeq[a.severity][a.producer];
+            if (a.seq <= last) fifoOk = false;
+            last = a.seq;
+        } else if (running.load() == 0 && q.empty()) {
+            break;
+        }
+    }
+    for (auto &t : threads) t.join();
+    double sec = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    cout << "Severity queue, " << producers << " producers x " << perProducer << " alerts\n";
+    cout << "  drained " << got << "/" << total << " in " << sec * 1e3 << " ms ("
+         << got / sec / 1e6 << " M alerts/s), FIFO within severity " << (fifoOk ? "ok" : "VIOLATED") << "\n";
+    for (auto &st : q.stats())
+        cout << "  sev " << st.severity << ": popped " << st.popped << ", avg dwell " << st.avgDwellUs
+             << " us, max dwell " << st.maxDwellUs << " us\n";
+}
+
+// side x side grid of rooms with corridors both ways and exits spread on the outer wall
+BuildingGraph makeBuildingGrid(int side, int exitCount, vector<int> &exits, mt19937 &rng) {
+    int n = side * side;
+    BuildingGraph g(n);
+    auto link = [&](int a, int b) {
+        int t = 1 + rng() % 5, cap = 20 + rng() % 80;
+        g[a].push_back({b, t, cap});
+        g[b].push_back({a, t, cap});
+    };
+    for (int r = 0; r < side; r++)
+        for (int c = 0; c < side; c++) {
+            int u = r * side + c;
+            if (c + 1 < side) link(u, u + 1);
+            if (r + 1 < side) link(u, u + side);
+        }
+    exits.clear();
+    for (int i = 0; i < exitCount; i++) {
+        int pos = (long long)i * (4 * (side - 1)) / exitCount, side4 = side - 1;
+        int r, c;
+        if (pos < side4) { r = 0; c = pos; }
+        else if (pos < 2 * side4) { r = pos - side4; c = side4; }
+        else if (pos < 3 * side4) { r = side4; c = 3 * side4 - pos; }
+        else { r = 4 * side4 - pos; c = 0; }
+        exits.push_back(r * side + c);
+    }
+    return g;
+}
+
+void benchmarkEvacuation(int side) {
+    mt19937 rng(11);
+    vector<int> exits;
+    BuildingGraph g = makeBuildingGrid(side, 16, exits, rng);
+    int n = g.size();
+
+    vector<int> occupants(n, 0);
+    vector<int> occupiedNodes;
+    for (int u = 0; u < n; u++)
+        if (rng() % 10 == 0) { occupants[u] = 1 + rng() % 5; occupiedNodes.push_back(u); }
+
+    // Old approach: one search per occupant (timed on a sample, then extrapolated)
+    vector<vector<pair<int,int>>> pairGraph(n);
+    for (int u = 0; u < n; u++) for (auto &c : g[u]) pairGraph[u].push_back({c.to, c.time});
+    int sample = min<int>(50, occupiedNodes.size());
+    auto t0 = chrono::steady_clock::now();
+    long long check = 0;
+    for (int i = 0; i < sample; i++) {
+        vector<int> d = dijkstra(pairGraph, occupiedNodes[i]);
+        int best = INT_MAX;
+        for (int e : exits) best = min(best, d[e]);
+        check += best;
+    }
+    double perSearch = chrono::duration<double>(chrono::steady_clock::now() - t0).count() / max(1, sample);
+
+    auto t1 = chrono::steady_clock::now();
+    EvacuationField f = buildEvacuationField(g, exits);
+    double fieldSec = chrono::duration<double>(chrono::steady_clock::now() - t1).count();
+    long long fieldCheck = 0;
+    for (int i = 0; i < sample; i++) fieldCheck += f.dist[occupiedNodes[i]];
+
+    auto t2 = chrono::steady_clock::now();
+    EvacuationFlow flow;
+    vector<int> exitCap(exits.size(), INT_MAX / 2);
+    CrowdAssignment a = flow.solve(g, occupants, exits, exitCap);
+    double flowSec = chrono::duration<double>(chrono::steady_clock::now() - t2).count();
+
+    cout << "Evacuation, " << n << " nodes, " << occupiedNodes.size() << " occupied rooms, " << exits.size() << " exits\n";
+    cout << "  per-occupant Dijkstra : " << perSearch * 1e3 << " ms each, ~"
+         << perSearch * occupiedNodes.size() << " s for everyone\n";
+    cout << "  all-exits field       : " << fieldSec * 1e3 << " ms total (sample "
+         << (check == fieldCheck ? "matches" : "DIFFERS") << ")\n";
+    cout << "  capacity-aware flow   : " << flowSec * 1e3 << " ms, evacuated " << a.evacuated
+         << ", stranded " << a.stranded << ", latest arrival " << a.latestArrival << ", " << a.groups.size() << " groups\n";
+}
+
+void benchmarkHazardRouting(int side, int occupants, int fireSeeds, int ticks) {
+    mt19937 rng(23);
+    vector<int> exits;
+    BuildingGraph g = makeBuildingGrid(side, 16, exits, rng);
+    int n = g.size();
+
+    vector<int> people(occupants);
+    for (int &p : people) p = rng() % n;
+    HazardRouter router(g, exits, people);
+    vector<int> seeds(fireSeeds);
+    for (int &s : seeds) s = rng() % n;
+    router.ignite(seeds);
+
+    double worst = 0, total = 0, fullTotal = 0;
+    long long blocked = 0, rerouted = 0, caught = 0, evacuated = 0;
+    bool valid = true;
+    for (int t = 0; t < ticks; t++) {
+        HazardTickStats st = router.spreadHazard();
+        worst = max(worst, st.micros);
+        total += st.micros;
+        blocked += st.newlyBlocked; rerouted += st.reroutedOccupants; caught += st.caughtOccupants;
+
+        auto f0 = chrono::steady_clock::now();
+        EvacuationField ref = router.recomputeFromScratch();
+        fullTotal += chrono::duration<double, micro>(chrono::steady_clock::now() - f0).count();
+        if (ref.dist != router.evacuationField().dist) valid = false;
+
+        evacuated += router.moveOccupants();
+    }
+
+    cout << "Hazard re-routing, " << n << " nodes, " << occupants << " occupants, " << fireSeeds
+         << " fire seeds, " << ticks << " ticks\n";
+    cout << "  blocked " << blocked << " nodes (" << blocked / max(1, ticks) << "/tick), rerouted "
+         << rerouted << " occupant reroutes, caught " << caught << ", evacuated " << evacuated << "\n";
+    cout << "  incremental repair : avg " << total / ticks / 1e3 << " ms, worst " << worst / 1e3 << " ms per tick\n";
+    cout << "  full recompute     : avg " << fullTotal / ticks / 1e3 << " ms per tick, fields "
+         << (valid ? "match" : "DIFFER") << "\n";
+}
+
 /*==========================================
                  MAIN SYSTEM
 ===========================================*/
-int main() {
+int main(int argc, char **argv) {
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        benchmarkAlertClassifier(argc > 2 ? atoi(argv[2]) : 2000000);
+        benchmarkSeverityQueue(4, 250000);
+        benchmarkEvacuation(317);   // ~100k nodes
+        benchmarkHazardRouting(317, 50000, 40, 30);
+        return 0;
+    }
+
     cout << "\n=== EMERGENCY ALERT SYSTEM ===\n";
 
     /* -------- Step 1: Detect Emergency Keyword -------- */
     string logText = "Smoke detected! Possible FIRE in Block A.";
-    vector<string> patterns = {"FIRE", "EARTHQUAKE", "FLOOD", "MEDICAL"};
+    AlertClass cls = classifyAlert(logText);
+
+    for (int k = 0; k < ALERT_KEYWORD_COUNT; k++) {
+        if (cls.mask >> k & 1u) {
+            alertQueue.push({ ALERT_KEYWORDS[k].severity, string("Emergency Detected: ") + ALERT_KEYWORDS[k].word });
+        }
+    }
 
-    for (string p : patterns) {
-        if (KMP_Search(logText, p)) {
-            alertHeap.push({ emergencyLevel[p], "Emergency Detected: " + p });
+    /* -------- Step 1b: Classify an alert message file (batch) -------- */
+    if (argc > 2 && string(argv[1]) == "--alerts") {
+        vector<ClassifiedMessage> classified;
+        if (!classifyAlertFile(argv[2], classified)) {
+            cout << "Could not open " << argv[2] << "\n";
+        } else {
+            for (auto &m : classified) {
+                if (m.cls.severity > 0)
+                    alertQueue.push({ m.cls.severity, "Message " + m.id + " flagged" });
+            }
         }
     }
 
@@ -140,27 +1011,58 @@ int main() {
     };
 
     if (bfsSafeZone(safeGraph, 0, 3)) {
-        alertHeap.push({6, "Safe zone reachable from current position."});
+        alertQueue.push({6, "Safe zone reachable from current position."});
     }
 
-    /* -------- Step 3: Dijkstra — Fastest Evacuation Path -------- */
-    vector<vector<pair<int,int>>> evacGraph = {
-        {{1, 4}},         // 0 → 1 (time 4)
-        {{2, 3}},         // 1 → 2 (time 3)
-        {{3, 2}},         // 2 → 3 (time 2)
-        {}                // 3 (exit)
+    /* -------- Step 3: Evacuation Field — Every Node's Nearest Exit -------- */
+    BuildingGraph building = {
+        {{1, 4, 30}, {4, 6, 10}},   // 0 → 1 (time 4), 0 → 4 (time 6)
+        {{2, 3, 30}},               // 1 → 2 (time 3)
+        {{3, 2, 15}},               // 2 → 3 (time 2)
+        {},                         // 3 (exit A)
+        {{5, 5, 10}},               // 4 → 5 (time 5)
+        {}                          // 5 (exit B)
     };
+    vector<int> exits = {3, 5};
+
+    EvacuationField field = buildEvacuationField(building, exits);
+    alertQueue.push({5, "Fastest evacuation time to exit: " + to_string(field.dist[0]) +
+                        " (exit " + to_string(field.nearestExit[0]) + ", next move to " + to_string(field.nextHop[0]) + ")"});
+
+    /* -------- Step 3a: Fire Reaches Node 1 — Repair Affected Routes Only -------- */
+    HazardRouter router(building, exits, {0, 0, 1, 2});
+    HazardTickStats tick = router.blockNodes({1});
+    const EvacuationField &live = router.evacuationField();
+    alertQueue.push({8, "Hazard blocked node 1: " + to_string(tick.reroutedOccupants) + " occupants rerouted, " +
+                        "node 0 now exits via " + to_string(live.nearestExit[0]) + " (time " + to_string(live.dist[0]) + ")"});
+    if (tick.trappedOccupants > 0)
+        alertQueue.push({9, to_string(tick.trappedOccupants) + " occupants trapped with no reachable exit"});
 
-    vector<int> dist = dijkstra(evacGraph, 0);
-    alertHeap.push({5, "Fastest evacuation time to exit: " + to_string(dist[3])});
+    /* -------- Step 3b: Min-Cost Flow — Spread Crowd Without Overloading Corridors -------- */
+    vector<int> occupants = {40, 0, 0, 0, 0, 0};
+    EvacuationFlow flow;
+    CrowdAssignment plan = flow.solve(building, occupants, exits, {100, 100});
+    for (auto &grp : plan.groups) {
+        alertQueue.push({5, to_string(grp.people) + " people from node " + to_string(grp.from) +
+                            " → exit " + to_string(grp.exit) + " (time " + to_string(grp.time) + ")"});
+    }
+    if (plan.stranded > 0)
+        alertQueue.push({9, to_string(plan.stranded) + " people cannot leave within corridor capacity"});
 
     /* -------- Step 4: Display Alerts (Highest Priority First) -------- */
     cout << "\n--- ALERTS (High → Low severity) ---\n";
-    while (!alertHeap.empty()) {
-        Alert a = alertHeap.top(); alertHeap.pop();
+    Alert a;
+    while (alertQueue.popMax(a)) {
         cout << "Severity: " << a.severity << " | " << a.message << "\n";
     }
 
+    cout << "\n--- Queue metrics per severity ---\n";
+    for (auto &st : alertQueue.stats()) {
+        if (st.popped == 0 && st.depth == 0) continue;
+        cout << "Severity " << st.severity << ": depth " << st.depth << ", popped " << st.popped
+             << ", avg dwell " << st.avgDwellUs << " us, max dwell " << st.maxDwellUs << " us\n";
+    }
+
     return 0;
 }
 
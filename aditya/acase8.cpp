@@ -2,9 +2,17 @@
 // High-complexity example for Shop & Restaurant Dynamic Pricing
 // Includes many data structures & algorithms for educational/demo use.
 //
-// Compile with: g++ -std=c++17 DynamicPricingSystem.cpp -O2 -o dynamic_pricing
+// Compile with: g++ -std=c++17 DynamicPricingSystem.cpp -O2 -pthread -o dynamic_pricing
 
 #include <bits/stdc++.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PRICING_X86 1
+#endif
 using namespace std;
 
 /* =========================
@@ -39,6 +47,13 @@ struct Order {
     Order(int oid, int iid, int q, int t, string c) : orderId(oid), itemId(iid), qty(q), timestampHour(t), customer(c) {}
 };
 
+// Compact order record for the concurrent path (slot already resolved from the item id)
+struct OrderLine {
+    int orderId;
+    int slot;
+    int qty;
+};
+
 struct SupplierEdge {
     int to;
     int timeCost; // e.g., minutes to deliver
@@ -79,58 +94,97 @@ public:
    Sorting Algorithms
    ========================= */
 
-void mergeSort(vector<Item> &arr, int l, int r, function<bool(const Item&, const Item&)> comp) {
+// Comparators are template parameters so they inline (no std::function call per comparison).
+// Every sort orders ascending by comp, i.e. comp(a, b) == true puts a first.
+
+template<typename T, typename Comp>
+void insertionSort(vector<T> &arr, int l, int r, Comp comp) {
+    for (int i = l + 1; i <= r; ++i) {
+        T v = move(arr[i]);
+        int j = i - 1;
+        while (j >= l && comp(v, arr[j])) { arr[j+1] = move(arr[j]); --j; }
+        arr[j+1] = move(v);
+    }
+}
+
+// Stable merge sort; one scratch buffer is allocated per call and reused at every level
+template<typename T, typename Comp>
+void mergeSortRange(vector<T> &arr, vector<T> &scratch, int l, int r, Comp comp) {
+    if (r - l < 24) { insertionSort(arr, l, r, comp); return; }
+    int m = l + (r - l) / 2;
+    mergeSortRange(arr, scratch, l, m, comp);
+    mergeSortRange(arr, scratch, m+1, r, comp);
+    if (!comp(arr[m+1], arr[m])) return; // halves already in order
+    int i = l, j = m+1, k = l;
+    while (i <= m && j <= r) scratch[k++] = comp(arr[j], arr[i]) ? move(arr[j++]) : move(arr[i++]);
+    while (i <= m) scratch[k++] = move(arr[i++]);
+    while (j <= r) scratch[k++] = move(arr[j++]);
+    for (k = l; k <= r; ++k) arr[k] = move(scratch[k]);
+}
+
+template<typename T, typename Comp>
+void mergeSort(vector<T> &arr, int l, int r, Comp comp) {
     if (l >= r) return;
-    int m = (l + r) / 2;
-    mergeSort(arr, l, m, comp);
-    mergeSort(arr, m+1, r, comp);
-    vector<Item> temp;
-    int i = l, j = m+1;
-    while (i <= m && j <= r) {
-        if (comp(arr[i], arr[j])) temp.push_back(arr[i++]);
-        else temp.push_back(arr[j++]);
-    }
-    while (i <= m) temp.push_back(arr[i++]);
-    while (j <= r) temp.push_back(arr[j++]);
-    for (int k = l; k <= r; ++k) arr[k] = temp[k - l];
-}
-
-int partition_quick(vector<Item> &arr, int low, int high, function<bool(const Item&, const Item&)> comp) {
-    Item pivot = arr[high];
-    int i = low - 1;
-    for (int j = low; j < high; ++j) {
-        if (comp(arr[j], pivot)) {
-            ++i;
+    vector<T> scratch(arr.size());
+    mergeSortRange(arr, scratch, l, r, comp);
+}
+
+// Introsort: median-of-3 Hoare partitioning, heap sort once recursion gets too deep,
+// insertion sort for the small leftovers. O(n log n) on sorted / reversed input too.
+template<typename T, typename Comp>
+void introSortLoop(vector<T> &arr, int lo, int hi, int depthLeft, Comp comp) {
+    while (hi - lo > 16) {
+        if (depthLeft-- == 0) {
+            make_heap(arr.begin()+lo, arr.begin()+hi+1, comp);
+            sort_heap(arr.begin()+lo, arr.begin()+hi+1, comp);
+            return;
+        }
+        int mid = lo + (hi - lo) / 2;
+        if (comp(arr[mid], arr[lo])) swap(arr[mid], arr[lo]);
+        if (comp(arr[hi], arr[lo])) swap(arr[hi], arr[lo]);
+        if (comp(arr[hi], arr[mid])) swap(arr[hi], arr[mid]);
+        T pivot = arr[mid]; // arr[lo] <= pivot <= arr[hi] act as sentinels
+
+        int i = lo, j = hi;
+        while (true) {
+            do ++i; while (comp(arr[i], pivot));
+            do --j; while (comp(pivot, arr[j]));
+            if (i >= j) break;
             swap(arr[i], arr[j]);
         }
+        // recurse into the smaller half, loop on the larger one (stack depth O(log n))
+        if (j - lo < hi - j) { introSortLoop(arr, lo, j, depthLeft, comp); lo = j + 1; }
+        else { introSortLoop(arr, j + 1, hi, depthLeft, comp); hi = j; }
     }
-    swap(arr[i+1], arr[high]);
-    return i+1;
 }
 
-void quickSort(vector<Item> &arr, int low, int high, function<bool(const Item&, const Item&)> comp) {
-    if (low < high) {
-        int pi = partition_quick(arr, low, high, comp);
-        quickSort(arr, low, pi-1, comp);
-        quickSort(arr, pi+1, high, comp);
-    }
+template<typename T, typename Comp>
+void quickSort(vector<T> &arr, int low, int high, Comp comp) {
+    if (low >= high) return;
+    int depth = 2 * (int)log2(high - low + 1);
+    introSortLoop(arr, low, high, depth, comp);
+    insertionSort(arr, low, high, comp);
 }
 
-// heap sort using comparator (ascending if comp(a,b) is a < b)
-void heapSort(vector<Item> &arr, function<bool(const Item&, const Item&)> comp) {
-    // We'll use std::make_heap with custom comparator that matches comp
-    // std::make_heap uses the comparator as "less" for max-heap; to sort by comp ascending, we invert comp accordingly.
-    auto heapComp = [&](const Item &a, const Item &b){
-        // want top of heap to be "largest" according to comp false; so invert:
-        return comp(a, b) == false;
-    };
-    make_heap(arr.begin(), arr.end(), heapComp);
-    for (int end = arr.size()-1; end > 0; --end) {
-        pop_heap(arr.begin(), arr.begin()+end+1, heapComp);
-        // after pop_heap, the largest is at arr[end], continue
-    }
+template<typename T, typename Comp>
+void heapSort(vector<T> &arr, Comp comp) {
+    make_heap(arr.begin(), arr.end(), comp);
+    sort_heap(arr.begin(), arr.end(), comp);
 }
 
+// Sorting 16-byte (key, slot) pairs instead of whole Items keeps the data moved per swap small
+struct SortKey {
+    double key;
+    int slot;
+};
+
+struct SortKeyLess {
+    bool operator()(const SortKey &a, const SortKey &b) const { return a.key < b.key || (a.key == b.key && a.slot < b.slot); }
+};
+struct SortKeyGreater {
+    bool operator()(const SortKey &a, const SortKey &b) const { return a.key > b.key || (a.key == b.key && a.slot < b.slot); }
+};
+
 /* =========================
    Searching
    ========================= */
@@ -148,156 +202,511 @@ int binarySearchIndex(const vector<Item> &arr, function<int(const Item&)> keyFun
     return -1;
 }
 
-/* =========================
-   BST and AVL Tree
-   ========================= */
+// Read-optimised id -> slot index: ids are packed 16 to a 64-byte node in an implicit
+// static B-tree (S-tree), so each level is one cache line, compared in two AVX2 ops, and
+// the next node's address is computed rather than loaded. Built in bulk from the catalog;
+// rebuild after the id set changes. findBatch walks groups of lookups level by level and
+// prefetches each next node, so the memory misses of a group overlap.
+class StaticIdIndex {
+    static constexpr int B = 16;
+    struct alignas(64) Node { int32_t key[B]; };
+    vector<Node> nodes;
+    vector<int32_t> slots;   // slot of nodes[k].key[i] at k * B + i
+    int height = 0;
+    int keys = 0;
 
-// Simple BST Node (used for demonstration)
-struct BSTNode {
-    Item val;
-    BSTNode *left, *right;
-    BSTNode(const Item &v) : val(v), left(nullptr), right(nullptr) {}
-};
+    static int child(int k, int i) { return k * (B + 1) + i + 1; }
+
+    // Fills nodes in in-order so the sorted input lands in search order
+    void fill(int k, const vector<pair<int, int>> &sorted, size_t &t) {
+        if (k >= (int)nodes.size()) return;
+        for (int i = 0; i < B; ++i) {
+            fill(child(k, i), sorted, t);
+            if (t < sorted.size()) { nodes[k].key[i] = sorted[t].first; slots[k * B + i] = sorted[t].second; t++; }
+            else { nodes[k].key[i] = INT_MAX; slots[k * B + i] = -1; }
+        }
+        fill(child(k, B), sorted, t);
+    }
 
-class BST {
-    BSTNode *root;
-    void insertNode(BSTNode *&node, const Item &val) {
-        if (!node) { node = new BSTNode(val); return; }
-        if (val.id < node->val.id) insertNode(node->left, val);
-        else if (val.id > node->val.id) insertNode(node->right, val);
-        else { node->val = val; } // update on equal id
+    // Number of keys in node k below id
+    static int rankScalar(const Node &n, int id) {
+        int r = 0;
+        for (int i = 0; i < B; ++i) r += n.key[i] < id;
+        return r;
     }
-    void inorder(BSTNode *node, vector<Item> &out) {
-        if (!node) return;
-        inorder(node->left, out);
-        out.push_back(node->val);
-        inorder(node->right, out);
+#ifdef PRICING_X86
+    __attribute__((target("avx2")))
+    static int rankAVX2(const Node &n, int id) {
+        __m256i x = _mm256_set1_epi32(id);
+        __m256i lo = _mm256_cmpgt_epi32(x, _mm256_load_si256((const __m256i*)n.key));
+        __m256i hi = _mm256_cmpgt_epi32(x, _mm256_load_si256((const __m256i*)(n.key + 8)));
+        unsigned mask = _mm256_movemask_ps(_mm256_castsi256_ps(lo)) | _mm256_movemask_ps(_mm256_castsi256_ps(hi)) << 8;
+        return __builtin_popcount(mask);
+    }
+#endif
+
+    template<int (*Rank)(const Node&, int)>
+    void findBatchImpl(const int *ids, int count, int *out) const {
+        constexpr int GROUP = 16;
+        const int nodeCount = nodes.size();
+        int k[GROUP], hit[GROUP];
+        for (int base = 0; base < count; base += GROUP) {
+            int g = min(GROUP, count - base);
+            for (int q = 0; q < g; ++q) { k[q] = 0; hit[q] = -1; }
+            for (int level = 0; level < height; ++level)
+                for (int q = 0; q < g; ++q) {
+                    if (k[q] >= nodeCount) continue;
+                    int i = Rank(nodes[k[q]], ids[base + q]);
+                    if (i < B) hit[q] = k[q] * B + i;   // lower-bound candidate
+                    k[q] = child(k[q], i);
+                    if (k[q] < nodeCount) __builtin_prefetch(&nodes[k[q]]);
+                }
+            for (int q = 0; q < g; ++q) {
+                int h = hit[q];
+                out[base + q] = h >= 0 && nodes[h / B].key[h % B] == ids[base + q] ? slots[h] : -1;
+            }
+        }
     }
+
+    using BatchFn = void (StaticIdIndex::*)(const int*, int, int*) const;
+    BatchFn batch = &StaticIdIndex::findBatchImpl<rankScalar>;
+
 public:
-    BST(): root(nullptr) {}
-    void insert(const Item &v) { insertNode(root, v); }
-    vector<Item> inOrder() { vector<Item> out; inorder(root, out); return out; }
-};
+    StaticIdIndex() {
+#ifdef PRICING_X86
+        if (__builtin_cpu_supports("avx2")) batch = &StaticIdIndex::findBatchImpl<rankAVX2>;
+#endif
+    }
+
+    // Bulk build from an id column (slot = position); ids must be unique
+    void rebuild(const vector<int> &idColumn) {
+        vector<pair<int, int>> sorted(idColumn.size());
+        for (int slot = 0; slot < (int)idColumn.size(); ++slot) sorted[slot] = {idColumn[slot], slot};
+        sort(sorted.begin(), sorted.end());
+        int nodeCount = (sorted.size() + B - 1) / B;
+        nodes.assign(nodeCount, Node{});
+        slots.assign((size_t)nodeCount * B, -1);
+        height = 0;
+        keys = sorted.size();
+        for (long long reach = 0; reach < nodeCount; reach = reach * (B + 1) + 1) height++;
+        size_t t = 0;
+        fill(0, sorted, t);
+    }
+
+    int size() const { return keys; }
+    size_t memoryBytes() const { return nodes.capacity() * sizeof(Node) + slots.capacity() * sizeof(int32_t); }
 
-// AVL Tree node
-struct AVLNode {
-    Item val;
-    AVLNode *left, *right;
-    int height;
-    AVLNode(const Item &v): val(v), left(nullptr), right(nullptr), height(1) {}
+    // slot of each id, -1 when absent
+    void findBatch(const int *ids, int count, int *out) const { (this->*batch)(ids, count, out); }
+    int find(int id) const {
+        int slot;
+        findBatch(&id, 1, &slot);
+        return slot;
+    }
 };
 
-int getHeight(AVLNode* n) { return n ? n->height : 0; }
-int getBalance(AVLNode* n) { return n ? getHeight(n->left) - getHeight(n->right) : 0; }
-void updateHeight(AVLNode* n) { if(n) n->height = 1 + max(getHeight(n->left), getHeight(n->right)); }
+/* =========================
+   Price-Ordered AVL Tree
+   ========================= */
 
-AVLNode* rotateRight(AVLNode* y) {
-    AVLNode* x = y->left;
-    AVLNode* T2 = x->right;
-    x->right = y;
-    y->left = T2;
-    updateHeight(y); updateHeight(x);
-    return x;
-}
+// AVL tree keyed by (price, id) whose nodes live in one index-linked pool: no per-node new,
+// freed nodes are recycled, and clear() drops the whole pool at once. Each node carries its
+// subtree size, so k-th / rank / range-count queries are O(log n) descents, and range
+// listing walks an explicit stack from the lower bound instead of copying the whole tree.
+class PriceTree {
+    struct Node {
+        double price;
+        int id;
+        int slot;       // catalog slot; the tree stores no Item copies
+        int left, right;
+        int size;
+        int height;
+    };
+    static constexpr int NIL = 0;   // pool[0] is a sentinel with size 0, height 0
+    vector<Node> pool;
+    vector<int> freeList;
+    int root = NIL;
 
-AVLNode* rotateLeft(AVLNode* x) {
-    AVLNode* y = x->right;
-    AVLNode* T2 = y->left;
-    y->left = x;
-    x->right = T2;
-    updateHeight(x); updateHeight(y);
-    return y;
-}
+    static bool keyLess(double price, int id, const Node &n) {
+        return price < n.price || (price == n.price && id < n.id);
+    }
+    static bool nodeLess(const Node &n, double price, int id) {
+        return n.price < price || (n.price == price && n.id < id);
+    }
+    void pull(int x) {
+        Node &n = pool[x];
+        n.size = 1 + pool[n.left].size + pool[n.right].size;
+        n.height = 1 + max(pool[n.left].height, pool[n.right].height);
+    }
+    int rotateRight(int y) {
+        int x = pool[y].left;
+        pool[y].left = pool[x].right;
+        pool[x].right = y;
+        pull(y); pull(x);
+        return x;
+    }
+    int rotateLeft(int x) {
+        int y = pool[x].right;
+        pool[x].right = pool[y].left;
+        pool[y].left = x;
+        pull(x); pull(y);
+        return y;
+    }
+    int rebalance(int x) {
+        pull(x);
+        int l = pool[x].left, r = pool[x].right;
+        int balance = pool[l].height - pool[r].height;
+        if (balance > 1) {
+            if (pool[pool[l].left].height < pool[pool[l].right].height) pool[x].left = rotateLeft(l);   // LR
+            return rotateRight(x);
+        }
+        if (balance < -1) {
+            if (pool[pool[r].right].height < pool[pool[r].left].height) pool[x].right = rotateRight(r); // RL
+            return rotateLeft(x);
+        }
+        return x;
+    }
+    int allocNode(double price, int id, int slot) {
+        int x;
+        if (!freeList.empty()) { x = freeList.back(); freeList.pop_back(); }
+        else { x = (int)pool.size(); pool.emplace_back(); }
+        pool[x] = {price, id, slot, NIL, NIL, 1, 1};
+        return x;
+    }
+    int insertAt(int x, double price, int id, int slot, bool &added) {
+        if (x == NIL) { added = true; return allocNode(price, id, slot); }
+        if (keyLess(price, id, pool[x])) {
+            int child = insertAt(pool[x].left, price, id, slot, added);
+            pool[x].left = child;
+        } else if (nodeLess(pool[x], price, id)) {
+            int child = insertAt(pool[x].right, price, id, slot, added);
+            pool[x].right = child;
+        } else {
+            pool[x].slot = slot;    // same key: update in place
+            return x;
+        }
+        return rebalance(x);
+    }
+    int detachMin(int x, int &minNode) {
+        if (pool[x].left == NIL) { minNode = x; return pool[x].right; }
+        pool[x].left = detachMin(pool[x].left, minNode);
+        return rebalance(x);
+    }
+    int eraseAt(int x, double price, int id, bool &removed) {
+        if (x == NIL) return NIL;
+        if (keyLess(price, id, pool[x])) pool[x].left = eraseAt(pool[x].left, price, id, removed);
+        else if (nodeLess(pool[x], price, id)) pool[x].right = eraseAt(pool[x].right, price, id, removed);
+        else {
+            removed = true;
+            int l = pool[x].left, r = pool[x].right;
+            freeList.push_back(x);
+            if (l == NIL || r == NIL) return l != NIL ? l : r;
+            int m;
+            r = detachMin(r, m);
+            pool[m].left = l;
+            pool[m].right = r;
+            return rebalance(m);
+        }
+        return rebalance(x);
+    }
 
-AVLNode* avlInsertNode(AVLNode* node, const Item &val) {
-    if (!node) return new AVLNode(val);
-    if (val.id < node->val.id) node->left = avlInsertNode(node->left, val);
-    else if (val.id > node->val.id) node->right = avlInsertNode(node->right, val);
-    else { node->val = val; return node; } // update
+public:
+    PriceTree() { clear(); }
 
-    updateHeight(node);
-    int balance = getBalance(node);
+    void reserve(size_t n) { pool.reserve(n + 1); }
+    int size() const { return pool[root].size; }
+    int height() const { return pool[root].height; }
+    size_t memoryBytes() const { return pool.capacity() * sizeof(Node) + freeList.capacity() * sizeof(int); }
 
-    // LL
-    if (balance > 1 && val.id < node->left->val.id) return rotateRight(node);
-    // RR
-    if (balance < -1 && val.id > node->right->val.id) return rotateLeft(node);
-    // LR
-    if (balance > 1 && val.id > node->left->val.id) {
-        node->left = rotateLeft(node->left);
-        return rotateRight(node);
-    }
-    // RL
-    if (balance < -1 && val.id < node->right->val.id) {
-        node->right = rotateRight(node->right);
-        return rotateLeft(node);
+    // Bulk destruction: every node goes with the pool
+    void clear() {
+        pool.assign(1, Node{0.0, 0, -1, NIL, NIL, 0, 0});
+        freeList.clear();
+        root = NIL;
     }
-    return node;
-}
 
-void avlInorder(AVLNode* node, vector<Item> &out) {
-    if (!node) return;
-    avlInorder(node->left, out);
-    out.push_back(node->val);
-    avlInorder(node->right, out);
-}
+    // Returns false when (price, id) was already present (its slot is updated)
+    bool insert(double price, int id, int slot) {
+        bool added = false;
+        root = insertAt(root, price, id, slot, added);
+        return added;
+    }
+    bool erase(double price, int id) {
+        bool removed = false;
+        root = eraseAt(root, price, id, removed);
+        return removed;
+    }
+    // Reposition an item after its price moved
+    void update(double oldPrice, double newPrice, int id, int slot) {
+        erase(oldPrice, id);
+        insert(newPrice, id, slot);
+    }
 
-class AVLTree {
-    AVLNode* root;
-public:
-    AVLTree(): root(nullptr) {}
-    void insert(const Item &v) { root = avlInsertNode(root, v); }
-    vector<Item> inOrder() { vector<Item> out; avlInorder(root, out); return out; }
+    // Number of keys strictly below (price, id)
+    int rank(double price, int id) const {
+        int x = root, r = 0;
+        while (x != NIL) {
+            const Node &n = pool[x];
+            if (nodeLess(n, price, id)) { r += pool[n.left].size + 1; x = n.right; }
+            else x = n.left;
+        }
+        return r;
+    }
+    // Slot of the k-th cheapest item (0-based), -1 when out of range
+    int kth(int k) const {
+        if (k < 0 || k >= size()) return -1;
+        int x = root;
+        while (true) {
+            const Node &n = pool[x];
+            int leftSize = pool[n.left].size;
+            if (k < leftSize) x = n.left;
+            else if (k == leftSize) return n.slot;
+            else { k -= leftSize + 1; x = n.right; }
+        }
+    }
+    // Items priced in [lo, hi]
+    int countInRange(double lo, double hi) const {
+        if (hi < lo) return 0;
+        return rank(hi, INT_MAX) - rank(lo, INT_MIN);
+    }
+    // Slots priced in [lo, hi] in ascending (price, id) order, at most `limit` of them
+    void collectRange(double lo, double hi, vector<int> &out, size_t limit = SIZE_MAX) const {
+        out.clear();
+        int stack[96];  // AVL height stays under 1.45 * log2(n + 2)
+        int top = 0;
+        for (int x = root; x != NIL;) {
+            if (pool[x].price >= lo) { stack[top++] = x; x = pool[x].left; }
+            else x = pool[x].right;
+        }
+        while (top > 0 && out.size() < limit) {
+            int x = stack[--top];
+            if (pool[x].price > hi) break;
+            out.push_back(pool[x].slot);
+            for (x = pool[x].right; x != NIL; x = pool[x].left) stack[top++] = x;
+        }
+    }
+    // Ascending-price visit of every item, fn(price, id, slot)
+    template<class Fn>
+    void forEachInOrder(Fn fn) const {
+        int stack[96];
+        int top = 0;
+        for (int x = root; x != NIL; x = pool[x].left) stack[top++] = x;
+        while (top > 0) {
+            int x = stack[--top];
+            fn(pool[x].price, pool[x].id, pool[x].slot);
+            for (x = pool[x].right; x != NIL; x = pool[x].left) stack[top++] = x;
+        }
+    }
 };
 
 /* =========================
-   Heaps (Min & Max)
+   Indexed Heaps (Min & Max)
    ========================= */
 
-// Max-heap of items by demand
-struct DemandComparator {
-    bool operator()(const Item &a, const Item &b) const {
-        return a.soldToday < b.soldToday;
+// Binary heap over dense catalog slots. pos[] tracks where each slot sits, so an
+// item's key is changed in place in O(log n) instead of pushing another copy.
+// Better(a, b) is true when key a belongs above key b.
+template<typename Key, typename Better>
+class IndexedHeap {
+    vector<int> heap;  // heap position -> slot
+    vector<int> pos;   // slot -> heap position (-1 = not in heap)
+    vector<Key> key;   // slot -> key
+    Better better;
+
+    bool above(int i, int j) const { return better(key[heap[i]], key[heap[j]]); }
+    void place(int i, int slot) { heap[i] = slot; pos[slot] = i; }
+    void siftUp(int i) {
+        int slot = heap[i];
+        while (i > 0) {
+            int parent = (i - 1) / 2;
+            if (!better(key[slot], key[heap[parent]])) break;
+            place(i, heap[parent]);
+            i = parent;
+        }
+        place(i, slot);
+    }
+    void siftDown(int i) {
+        int n = heap.size(), slot = heap[i];
+        while (true) {
+            int c = 2 * i + 1;
+            if (c >= n) break;
+            if (c + 1 < n && above(c + 1, c)) c++;
+            if (!better(key[heap[c]], key[slot])) break;
+            place(i, heap[c]);
+            i = c;
+        }
+        place(i, slot);
+    }
+public:
+    // Reserve slots up front for a fixed footprint (4 + 4 + sizeof(Key) bytes per slot)
+    explicit IndexedHeap(int capacity = 0) { reserve(capacity); }
+    void reserve(int capacity) {
+        if (capacity <= (int)pos.size()) return;
+        pos.resize(capacity, -1);
+        key.resize(capacity);
+        heap.reserve(capacity);
+    }
+
+    bool empty() const { return heap.empty(); }
+    size_t size() const { return heap.size(); }
+    bool contains(int slot) const { return slot < (int)pos.size() && pos[slot] >= 0; }
+    int top() const { return heap.front(); }
+    Key keyOf(int slot) const { return key[slot]; }
+    size_t memoryBytes() const {
+        return heap.capacity() * sizeof(int) + pos.capacity() * sizeof(int) + key.capacity() * sizeof(Key);
+    }
+
+    // Insert the slot, or move it to its new key if already present
+    void set(int slot, Key k) {
+        if (slot >= (int)pos.size()) reserve(max(slot + 1, 2 * (int)pos.size()));
+        if (pos[slot] < 0) {
+            key[slot] = k;
+            heap.push_back(slot);
+            siftUp(heap.size() - 1);
+            return;
+        }
+        bool up = better(k, key[slot]);
+        key[slot] = k;
+        if (up) siftUp(pos[slot]);
+        else siftDown(pos[slot]);
+    }
+
+    void erase(int slot) {
+        if (!contains(slot)) return;
+        int i = pos[slot], last = heap.back();
+        heap.pop_back();
+        pos[slot] = -1;
+        if (i == (int)heap.size()) return;
+        place(i, last);
+        siftUp(i);
+        siftDown(pos[last]);
     }
-};
 
-// Min-heap by currentPrice
-struct PriceMinComparator {
-    bool operator()(const Item &a, const Item &b) const {
-        return a.currentPrice > b.currentPrice; // invert for min-heap using priority_queue
+    // Best k slots in order, exploring only O(k) heap nodes (the heap is left untouched)
+    void topK(int k, vector<int> &out) const {
+        out.clear();
+        if (heap.empty() || k <= 0) return;
+        auto worse = [&](int i, int j) { return above(j, i); };
+        vector<int> frontier = {0};   // heap positions, itself a heap by worse()
+        while (!frontier.empty() && (int)out.size() < k) {
+            pop_heap(frontier.begin(), frontier.end(), worse);
+            int i = frontier.back(); frontier.pop_back();
+            out.push_back(heap[i]);
+            for (int c = 2 * i + 1; c <= 2 * i + 2 && c < (int)heap.size(); c++) {
+                frontier.push_back(c);
+                push_heap(frontier.begin(), frontier.end(), worse);
+            }
+        }
     }
 };
 
+using DemandHeap = IndexedHeap<int, greater<int>>;     // most soldToday on top
+using PriceHeap = IndexedHeap<double, less<double>>;   // cheapest currentPrice on top
+
 /* =========================
-   Hash Table (fast lookup)
+   Columnar Catalog + Hash Index
    ========================= */
 
+// Struct-of-arrays item store: each field is its own contiguous column indexed by slot,
+// so bulk passes (repricing, ranking) stream only the columns they need.
+struct CatalogColumns {
+    vector<int> id;
+    vector<string> name;
+    vector<double> basePrice;
+    vector<int> stock;
+    vector<int> soldToday;
+    vector<int> dailyViews;
+    vector<int> expiryDays;
+    vector<uint8_t> perishable;
+    vector<int> lastUpdateHour;
+    vector<double> currentPrice;
+
+    int size() const { return id.size(); }
+    void reserve(size_t n) {
+        id.reserve(n); name.reserve(n); basePrice.reserve(n); stock.reserve(n); soldToday.reserve(n);
+        dailyViews.reserve(n); expiryDays.reserve(n); perishable.reserve(n); lastUpdateHour.reserve(n);
+        currentPrice.reserve(n);
+    }
+    void append(const Item &it) {
+        id.push_back(it.id); name.push_back(it.name); basePrice.push_back(it.basePrice);
+        stock.push_back(it.stock); soldToday.push_back(it.soldToday); dailyViews.push_back(it.dailyViews);
+        expiryDays.push_back(it.expiryDays); perishable.push_back(it.perishable);
+        lastUpdateHour.push_back(it.lastUpdateHour); currentPrice.push_back(it.currentPrice);
+    }
+    void assign(int slot, const Item &it) {
+        id[slot] = it.id; name[slot] = it.name; basePrice[slot] = it.basePrice;
+        stock[slot] = it.stock; soldToday[slot] = it.soldToday; dailyViews[slot] = it.dailyViews;
+        expiryDays[slot] = it.expiryDays; perishable[slot] = it.perishable;
+        lastUpdateHour[slot] = it.lastUpdateHour; currentPrice[slot] = it.currentPrice;
+    }
+    Item row(int slot) const {
+        Item it(id[slot], name[slot], basePrice[slot], stock[slot], perishable[slot], expiryDays[slot]);
+        it.soldToday = soldToday[slot]; it.dailyViews = dailyViews[slot];
+        it.lastUpdateHour = lastUpdateHour[slot]; it.currentPrice = currentPrice[slot];
+        return it;
+    }
+};
+
+// The slot number is what heaps, sort keys and pricing kernels index by.
 class ItemCatalog {
-    unordered_map<int, Item> idMap; // id -> item
+    CatalogColumns cols;
+    unordered_map<int, int> idToSlot;    // id -> slot
     unordered_map<string, int> nameToId; // name -> id
+    mutable StaticIdIndex idIndex;       // bulk lookups; rebuilt by the first reader after new ids arrived
+    mutable atomic<bool> idIndexStale{true};
+    mutable mutex idIndexLock;           // one rebuild while concurrent readers wait
 public:
-    void addOrUpdate(const Item &it) {
-        idMap[it.id] = it;
+    int addOrUpdate(const Item &it) {
+        auto found = idToSlot.find(it.id);
+        int slot;
+        if (found != idToSlot.end()) {
+            slot = found->second;
+            cols.assign(slot, it);
+        } else {
+            slot = cols.size();
+            cols.append(it);
+            idToSlot[it.id] = slot;
+            idIndexStale = true;
+        }
         nameToId[it.name] = it.id;
+        return slot;
     }
-    bool existsId(int id) const { return idMap.find(id) != idMap.end(); }
+    void reserve(size_t n) { cols.reserve(n); idToSlot.reserve(n); nameToId.reserve(n); }
+    bool existsId(int id) const { return idToSlot.find(id) != idToSlot.end(); }
     bool existsName(const string &name) const { return nameToId.find(name) != nameToId.end(); }
-    Item* getById(int id) {
-        if (idMap.find(id) == idMap.end()) return nullptr;
-        return &idMap[id];
-    }
-    Item* getByName(const string &name) {
-        if (nameToId.find(name) == nameToId.end()) return nullptr;
-        int id = nameToId.at(name);
-        return &idMap[id];
-    }
-    vector<Item> allItems() const {
-        vector<Item> out; out.reserve(idMap.size());
-        for (auto &p : idMap) out.push_back(p.second);
-        return out;
+    int slotOf(int id) const {
+        auto found = idToSlot.find(id);
+        return found == idToSlot.end() ? -1 : found->second;
     }
+    int slotOfName(const string &name) const {
+        auto found = nameToId.find(name);
+        return found == nameToId.end() ? -1 : slotOf(found->second);
+    }
+    // slotOf for many ids at once (-1 when absent). Safe from several reader threads;
+    // not concurrently with addOrUpdate.
+    void slotsOf(const int *ids, int count, int *out) const {
+        if (idIndexStale.load(memory_order_acquire)) {
+            lock_guard<mutex> lk(idIndexLock);
+            if (idIndexStale.load(memory_order_relaxed)) {
+                idIndex.rebuild(cols.id);
+                idIndexStale.store(false, memory_order_release);
+            }
+        }
+        idIndex.findBatch(ids, count, out);
+    }
+    int size() const { return cols.size(); }
+    CatalogColumns &columns() { return cols; }
+    const CatalogColumns &columns() const { return cols; }
+    Item row(int slot) const { return cols.row(slot); }   // materialised copy, for printing / demos
 };
 
+template<typename T>
+vector<SortKey> sortKeys(const vector<T> &column) {
+    vector<SortKey> keys(column.size());
+    for (int slot = 0; slot < (int)column.size(); ++slot) keys[slot] = {(double)column[slot], slot};
+    return keys;
+}
+
 /* =========================
    Graph: Supplier Routing & Dijkstra
    ========================= */
@@ -330,21 +739,33 @@ vector<int> dijkstraShortest(const Graph &g, int src) {
    Dynamic Pricing Engine
    ========================= */
 
+// timeFactor: peak lunch/dinner increases price slightly
+double hourTimeFactor(int currentHour) {
+    if (currentHour >= 11 && currentHour <= 14) return 0.10; // lunch peak
+    if (currentHour >= 19 && currentHour <= 22) return 0.15; // dinner peak
+    if (currentHour >= 22 || currentHour <= 5) return -0.12; // late-night discount
+    return 0.0;
+}
+
+// Coefficients of the pricing formula; the defaults are the live policy
+struct PricingPolicy {
+    double alpha = 0.02;  // impact of soldToday
+    double beta = 0.001;  // impact of stock
+    double gamma = 0.05;  // time-of-day factor (peak times)
+    double delta = 0.05;  // expiry sensitivity (perishables only)
+};
+
 // Pricing formula: base * (1 + alpha * demandIndex - beta * stockIndex + gamma * timeFactor - delta * expiryFactor)
-double computeDynamicPrice(const Item &it, int currentHour) {
-    double alpha = 0.02; // impact of soldToday
-    double beta = 0.001; // impact of stock
-    double gamma = 0.05; // time-of-day factor (peak times)
-    double delta = it.perishable ? 0.05 : 0.0; // expiry sensitivity
+double computeDynamicPrice(const Item &it, int currentHour, const PricingPolicy &policy = PricingPolicy()) {
+    double alpha = policy.alpha;
+    double beta = policy.beta;
+    double gamma = policy.gamma;
+    double delta = it.perishable ? policy.delta : 0.0;
 
     double demandIndex = min(200.0, (double)it.soldToday); // cap
     double stockIndex = max(1.0, (double)it.stock);
 
-    // timeFactor: peak lunch/dinner increases price slightly
-    double timeFactor = 0.0;
-    if (currentHour >= 11 && currentHour <= 14) timeFactor = 0.10; // lunch peak
-    else if (currentHour >= 19 && currentHour <= 22) timeFactor = 0.15; // dinner peak
-    else if (currentHour >= 22 || currentHour <= 5) timeFactor = -0.12; // late-night discount
+    double timeFactor = hourTimeFactor(currentHour);
 
     // expiryFactor: if expiry is close, discount
     double expiryFactor = 0.0;
@@ -359,6 +780,557 @@ double computeDynamicPrice(const Item &it, int currentHour) {
     return round(price * 100.0) / 100.0; // round to 2 decimals
 }
 
+/* =========================
+   Bulk Repricing (columnar, SIMD)
+   ========================= */
+
+// Same formula as computeDynamicPrice, written branch-free over the catalog columns:
+// every condition becomes a min/max/blend so all lanes run the same instructions.
+// floor(x + 0.5) equals round(x) here because x = price * 100 >= 10.
+struct PriceColumnsView {
+    const double *basePrice;
+    const int *stock, *soldToday, *expiryDays;
+    const uint8_t *perishable;
+    double *currentPrice;
+    int *lastUpdateHour;
+    PricingPolicy policy;
+};
+
+void repriceRangeScalar(const PriceColumnsView &c, int begin, int end, int hour) {
+    const double alpha = c.policy.alpha, beta = c.policy.beta, gamma = c.policy.gamma, delta = c.policy.delta;
+    const double timeTerm = gamma * hourTimeFactor(hour);
+    for (int i = begin; i < end; ++i) {
+        double demandIndex = min(200.0, (double)c.soldToday[i]);
+        double stockIndex = max(1.0, (double)c.stock[i]);
+        double nearExpiry = (double)max(0, 7 - c.expiryDays[i]) * 0.05;
+        double expiryFactor = c.expiryDays[i] <= 1 ? 0.40 : nearExpiry;
+        double expiryTerm = (double)c.perishable[i] * (delta * expiryFactor);
+        double price = c.basePrice[i] * (1.0 + alpha * demandIndex - beta * stockIndex + timeTerm - expiryTerm);
+        price = max(price, 0.1);
+        c.currentPrice[i] = floor(price * 100.0 + 0.5) / 100.0;
+        c.lastUpdateHour[i] = hour;
+    }
+}
+
+#ifdef PRICING_X86
+__attribute__((target("avx2")))
+void repriceRangeAVX2(const PriceColumnsView &c, int begin, int end, int hour) {
+    const __m256d alpha = _mm256_set1_pd(c.policy.alpha), beta = _mm256_set1_pd(c.policy.beta), one = _mm256_set1_pd(1.0);
+    const __m256d cap = _mm256_set1_pd(200.0), floorPrice = _mm256_set1_pd(0.1), half = _mm256_set1_pd(0.5);
+    const __m256d hundred = _mm256_set1_pd(100.0), step = _mm256_set1_pd(0.05), heavy = _mm256_set1_pd(0.40);
+    const __m256d timeTerm = _mm256_set1_pd(c.policy.gamma * hourTimeFactor(hour));
+    const __m256d delta = _mm256_set1_pd(c.policy.delta);
+    const __m128i seven = _mm_set1_epi32(7), zero = _mm_setzero_si128(), hours = _mm_set1_epi32(hour);
+    int i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m256d demand = _mm256_min_pd(cap, _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)(c.soldToday + i))));
+        __m256d stockIdx = _mm256_max_pd(one, _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)(c.stock + i))));
+        __m128i exp32 = _mm_loadu_si128((const __m128i*)(c.expiryDays + i));
+        __m256d nearExpiry = _mm256_mul_pd(_mm256_cvtepi32_pd(_mm_max_epi32(zero, _mm_sub_epi32(seven, exp32))), step);
+        __m256d isLast = _mm256_cmp_pd(_mm256_cvtepi32_pd(exp32), one, _CMP_LE_OQ);
+        __m256d expiryFactor = _mm256_blendv_pd(nearExpiry, heavy, isLast);
+        int32_t flags;
+        memcpy(&flags, c.perishable + i, 4);
+        __m256d perish = _mm256_cvtepi32_pd(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(flags)));
+        __m256d expiryTerm = _mm256_mul_pd(perish, _mm256_mul_pd(delta, expiryFactor));
+
+        __m256d factor = _mm256_add_pd(one, _mm256_mul_pd(alpha, demand));
+        factor = _mm256_sub_pd(factor, _mm256_mul_pd(beta, stockIdx));
+        factor = _mm256_add_pd(factor, timeTerm);
+        factor = _mm256_sub_pd(factor, expiryTerm);
+        __m256d price = _mm256_max_pd(_mm256_mul_pd(_mm256_loadu_pd(c.basePrice + i), factor), floorPrice);
+        price = _mm256_div_pd(_mm256_floor_pd(_mm256_add_pd(_mm256_mul_pd(price, hundred), half)), hundred);
+        _mm256_storeu_pd(c.currentPrice + i, price);
+        _mm_storeu_si128((__m128i*)(c.lastUpdateHour + i), hours);
+    }
+    repriceRangeScalar(c, i, end, hour);
+}
+
+// AVX-512 implies FMA; fp-contract=off keeps results bit-identical to the scalar formula.
+// GCC 12's avx512fintrin.h trips -Wmaybe-uninitialized on its own undefined pass-through operands.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+__attribute__((target("avx512f"), optimize("fp-contract=off")))
+void repriceRangeAVX512(const PriceColumnsView &c, int begin, int end, int hour) {
+    const __m512d alpha = _mm512_set1_pd(c.policy.alpha), beta = _mm512_set1_pd(c.policy.beta), one = _mm512_set1_pd(1.0);
+    const __m512d cap = _mm512_set1_pd(200.0), floorPrice = _mm512_set1_pd(0.1), half = _mm512_set1_pd(0.5);
+    const __m512d hundred = _mm512_set1_pd(100.0), step = _mm512_set1_pd(0.05), heavy = _mm512_set1_pd(0.40);
+    const __m512d timeTerm = _mm512_set1_pd(c.policy.gamma * hourTimeFactor(hour));
+    const __m512d delta = _mm512_set1_pd(c.policy.delta);
+    const __m256i seven = _mm256_set1_epi32(7), zero = _mm256_setzero_si256(), hours = _mm256_set1_epi32(hour);
+    int i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m512d demand = _mm512_min_pd(cap, _mm512_cvtepi32_pd(_mm256_loadu_si256((const __m256i*)(c.soldToday + i))));
+        __m512d stockIdx = _mm512_max_pd(one, _mm512_cvtepi32_pd(_mm256_loadu_si256((const __m256i*)(c.stock + i))));
+        __m256i exp32 = _mm256_loadu_si256((const __m256i*)(c.expiryDays + i));
+        __m512d nearExpiry = _mm512_mul_pd(_mm512_cvtepi32_pd(_mm256_max_epi32(zero, _mm256_sub_epi32(seven, exp32))), step);
+        __mmask8 isLast = _mm512_cmp_pd_mask(_mm512_cvtepi32_pd(exp32), one, _CMP_LE_OQ);
+        __m512d expiryFactor = _mm512_mask_blend_pd(isLast, nearExpiry, heavy);
+        __m512d perish = _mm512_cvtepi32_pd(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(c.perishable + i))));
+        __m512d expiryTerm = _mm512_mul_pd(perish, _mm512_mul_pd(delta, expiryFactor));
+
+        __m512d factor = _mm512_add_pd(one, _mm512_mul_pd(alpha, demand));
+        factor = _mm512_sub_pd(factor, _mm512_mul_pd(beta, stockIdx));
+        factor = _mm512_add_pd(factor, timeTerm);
+        factor = _mm512_sub_pd(factor, expiryTerm);
+        __m512d price = _mm512_max_pd(_mm512_mul_pd(_mm512_loadu_pd(c.basePrice + i), factor), floorPrice);
+        price = _mm512_div_pd(_mm512_floor_pd(_mm512_add_pd(_mm512_mul_pd(price, hundred), half)), hundred);
+        _mm512_storeu_pd(c.currentPrice + i, price);
+        _mm256_storeu_si256((__m256i*)(c.lastUpdateHour + i), hours);
+    }
+    repriceRangeScalar(c, i, end, hour);
+}
+#pragma GCC diagnostic pop
+#endif
+
+using RepriceKernel = void (*)(const PriceColumnsView &, int, int, int);
+
+// Widest kernel this CPU supports, chosen once
+RepriceKernel selectRepriceKernel(const char **name = nullptr) {
+    const char *chosen = "scalar";
+    RepriceKernel k = repriceRangeScalar;
+#ifdef PRICING_X86
+    if (__builtin_cpu_supports("avx512f")) { k = repriceRangeAVX512; chosen = "avx512f"; }
+    else if (__builtin_cpu_supports("avx2")) { k = repriceRangeAVX2; chosen = "avx2"; }
+#endif
+    if (name) *name = chosen;
+    return k;
+}
+
+// Reprices every slot, splitting the columns into one contiguous chunk per thread
+void repriceCatalog(CatalogColumns &c, int hour, int threads = 0, RepriceKernel kernel = nullptr,
+                    const PricingPolicy &policy = PricingPolicy()) {
+    static const RepriceKernel best = selectRepriceKernel();
+    if (!kernel) kernel = best;
+    int n = c.size();
+    PriceColumnsView view{c.basePrice.data(), c.stock.data(), c.soldToday.data(), c.expiryDays.data(),
+                          c.perishable.data(), c.currentPrice.data(), c.lastUpdateHour.data(), policy};
+    if (threads <= 0) threads = max(1u, thread::hardware_concurrency());
+    threads = max(1, min(threads, n / 65536));   // small catalogs are not worth a thread
+    if (threads == 1) { kernel(view, 0, n, hour); return; }
+    vector<thread> pool;
+    int chunk = (n + threads - 1) / threads;
+    chunk = (chunk + 7) & ~7;                    // keep chunk starts vector-aligned
+    for (int begin = 0; begin < n; begin += chunk)
+        pool.emplace_back(kernel, cref(view), begin, min(n, begin + chunk), hour);
+    for (auto &th : pool) th.join();
+}
+
+/* =========================
+   Incremental Pricing Engine
+   ========================= */
+
+// computeDynamicPrice only moves when soldToday, stock or expiryDays change, or when the
+// clock crosses a time-of-day band. Mutations mark slots dirty; a tick reprices the dirty
+// set in sorted contiguous runs, or the whole catalog on a band transition (or when so much
+// is dirty that one streaming pass is cheaper), and publishes what changed. lastUpdateHour
+// is stamped only on the slots a tick actually repriced; every price is current as of
+// pricedAsOf(). Slots appended to the columns since the last tick are priced by the next.
+struct PriceChange {
+    int slot;
+    double oldPrice;
+    double newPrice;
+    int hour;
+};
+
+struct PricingTickStats {
+    int hour = 0;
+    bool bandChanged = false;   // whole catalog repriced
+    long long repriced = 0;
+    long long skipped = 0;
+    long long changed = 0;      // price actually moved (= change-stream events)
+    long long writtenOff = 0;   // units discarded through writeOff (cumulative only)
+    double micros = 0;
+};
+
+class PricingEngine {
+public:
+    using Listener = function<void(const vector<PriceChange>&)>;   // called once per batch
+
+    static constexpr int NO_BAND = -1;
+    // Band of each hour, precomputed from hourTimeFactor (equal factor = same band)
+    static const array<int8_t, 24> &bandOfHour() {
+        static const array<int8_t, 24> table = [] {
+            array<int8_t, 24> t{};
+            vector<double> factors;
+            for (int h = 0; h < 24; ++h) {
+                double f = hourTimeFactor(h);
+                auto it = find(factors.begin(), factors.end(), f);
+                if (it == factors.end()) { factors.push_back(f); it = factors.end() - 1; }
+                t[h] = (int8_t)(it - factors.begin());
+            }
+            return t;
+        }();
+        return table;
+    }
+
+    explicit PricingEngine(CatalogColumns &columns, const PricingPolicy &policy = PricingPolicy())
+        : c(columns), policy(policy), isDirty(columns.size(), 0), tracked(columns.size()) {}
+
+    void subscribe(Listener l) { listeners.push_back(move(l)); }
+
+    void markDirty(int slot) {
+        if (slot >= (int)isDirty.size()) isDirty.resize(c.size(), 0);
+        if (!isDirty[slot]) { isDirty[slot] = 1; dirty.push_back(slot); }
+    }
+    // Mutators that keep the dirty set honest
+    void recordSale(int slot, int qty) { c.stock[slot] -= qty; c.soldToday[slot] += qty; markDirty(slot); }
+    void restock(int slot, int qty) {
+        if (qty <= 0) return;
+        c.stock[slot] += qty;
+        markDirty(slot);
+    }
+    // Discards up to qty units (expired, damaged); they are not sales
+    void writeOff(int slot, int qty) {
+        qty = min(qty, c.stock[slot]);
+        if (qty <= 0) return;
+        c.stock[slot] -= qty;
+        totals.writtenOff += qty;
+        markDirty(slot);
+    }
+    void setExpiry(int slot, int days) { c.expiryDays[slot] = days; markDirty(slot); }
+    void newDay() {   // soldToday resets and perishables move one day closer to expiry
+        for (int slot = 0; slot < c.size(); ++slot) {
+            c.soldToday[slot] = 0;
+            if (c.perishable[slot]) c.expiryDays[slot] = max(0, c.expiryDays[slot] - 1);
+        }
+        lastBand = NO_BAND;   // everything may have moved
+    }
+
+    PricingTickStats tick(int hour) {
+        auto t0 = chrono::steady_clock::now();
+        PricingTickStats st;
+        st.hour = hour;
+        int n = c.size();
+        if ((int)isDirty.size() < n) isDirty.resize(n, 0);
+        for (; tracked < n; ++tracked) markDirty(tracked);   // new SKUs have no price yet
+        changes.clear();
+        PriceColumnsView view{c.basePrice.data(), c.stock.data(), c.soldToday.data(), c.expiryDays.data(),
+                              c.perishable.data(), c.currentPrice.data(), c.lastUpdateHour.data(), policy};
+
+        int band = bandOfHour()[hour];
+        // Scattered slots cost a few cache misses each; past about 1 in FULL_PASS_RATIO
+        // dirty, streaming the whole catalog through the kernel is cheaper
+        if (band != lastBand || (long long)dirty.size() * FULL_PASS_RATIO > n) {
+            st.bandChanged = band != lastBand;
+            repriceAll(view, hour, st);
+            st.repriced = n;
+            lastBand = band;
+        } else {
+            sort(dirty.begin(), dirty.end());
+            for (size_t i = 0; i < dirty.size();) {
+                size_t j = i + 1;
+                while (j < dirty.size() && dirty[j] == dirty[j - 1] + 1) ++j;
+                st.changed += repriceDiff(view, dirty[i], dirty[i] + (int)(j - i), hour, listening() ? &changes : nullptr);
+                if (changes.size() >= BATCH) flush();
+                i = j;
+            }
+            st.repriced = dirty.size();
+        }
+        asOf = hour;
+        for (int slot : dirty) isDirty[slot] = 0;
+        dirty.clear();
+
+        flush();
+        st.skipped = n - st.repriced;
+        totals.repriced += st.repriced;
+        totals.skipped += st.skipped;
+        totals.changed += st.changed;
+        st.micros = chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count();
+        return st;
+    }
+
+    const PricingTickStats &cumulative() const { return totals; }
+    int pricedAsOf() const { return asOf; }   // hour of the last tick, -1 before the first
+    size_t pendingDirty() const { return dirty.size(); }
+
+private:
+    CatalogColumns &c;
+    PricingPolicy policy;
+    vector<uint8_t> isDirty;
+    vector<int> dirty;
+    RepriceKernel kernel = selectRepriceKernel();
+    vector<PriceChange> changes;
+    vector<Listener> listeners;
+    int lastBand = NO_BAND;
+    int tracked;        // slots the engine has seen; later appends get marked dirty
+    int asOf = -1;
+    PricingTickStats totals;
+
+    static constexpr int FULL_PASS_RATIO = 32;
+    static constexpr int DIFF_BLOCK = 2048;
+
+    bool listening() const { return !listeners.empty(); }
+
+    // Reprices [begin, end) in cache-sized blocks, comparing each block with its old
+    // prices while both are still in L1. Changes are only materialised when out is set.
+    long long repriceDiff(const PriceColumnsView &view, int begin, int end, int hour, vector<PriceChange> *out) const {
+        double old[DIFF_BLOCK];
+        long long changed = 0;
+        for (int b = begin; b < end; b += DIFF_BLOCK) {
+            int e = min(end, b + DIFF_BLOCK);
+            memcpy(old, view.currentPrice + b, (e - b) * sizeof(double));
+            (e - b < 8 ? repriceRangeScalar : kernel)(view, b, e, hour);   // lone slots skip the SIMD setup
+            for (int i = b; i < e; ++i) {
+                if (view.currentPrice[i] == old[i - b]) continue;
+                ++changed;
+                if (out) out->push_back({i, old[i - b], view.currentPrice[i], hour});
+            }
+        }
+        return changed;
+    }
+
+    // Whole-catalog pass, one contiguous chunk per thread like repriceCatalog. With
+    // subscribers each thread collects its chunk's changes, streamed in slot order after.
+    void repriceAll(const PriceColumnsView &view, int hour, PricingTickStats &st) {
+        int n = c.size();
+        int threads = max(1, min((int)max(1u, thread::hardware_concurrency()), n / 65536));
+        int chunk = ((n + threads - 1) / threads + 7) & ~7;
+        threads = n == 0 ? 1 : (n + chunk - 1) / chunk;
+        if (threads == 1) {   // stream straight into the outgoing batch
+            for (int b = 0; b < n; b += (int)BATCH) {
+                st.changed += repriceDiff(view, b, min(n, b + (int)BATCH), hour, listening() ? &changes : nullptr);
+                flush();
+            }
+            return;
+        }
+        vector<long long> counts(threads, 0);
+        vector<vector<PriceChange>> found(listening() ? threads : 0);
+        auto work = [&](int t) {
+            int begin = t * chunk;
+            counts[t] = repriceDiff(view, begin, min(n, begin + chunk), hour, found.empty() ? nullptr : &found[t]);
+        };
+        vector<thread> pool;
+        for (int t = 0; t < threads; ++t) pool.emplace_back(work, t);
+        for (auto &th : pool) th.join();
+        for (long long k : counts) st.changed += k;
+        for (auto &part : found)
+            for (size_t i = 0; i < part.size(); i += BATCH) {
+                changes.assign(part.begin() + i, part.begin() + min(part.size(), i + BATCH));
+                flush();
+            }
+    }
+
+    // The change stream is delivered in batches of at most BATCH events
+    static constexpr size_t BATCH = 1 << 16;
+    void flush() {
+        if (!changes.empty())
+            for (auto &l : listeners) l(changes);
+        changes.clear();
+    }
+};
+
+/* =========================
+   Order Write-Ahead Log
+   ========================= */
+
+// Append-only order log with group commit. Writers encode records into a shared buffer
+// and block until a flusher thread has written and fdatasync'ed it; everything appended
+// during one flush window goes out in a single write + sync. Records carry a CRC32C, so
+// replay stops cleanly at a torn tail left by a crash.
+//
+// Record: [u32 payload length][u32 crc32c(payload)][payload]
+// Payload: u8 type, i32 orderId, i32 itemId, i32 qty, i32 hour, u16 name length, name bytes
+
+uint32_t crc32c(const uint8_t *p, size_t n, uint32_t crc = 0) {
+    static const array<uint32_t, 256> table = [] {
+        array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = c & 1 ? 0x82F63B78u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+    crc = ~crc;
+    for (size_t i = 0; i < n; ++i) crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+enum class OrderLogType : uint8_t {
+    Placed = 1,
+    Fulfilled = 2,   // stock -= qty, soldToday += qty (orderId 0 = bulk sale)
+    Failed = 3,
+    Restock = 4,     // stock += qty
+    WriteOff = 5     // stock -= qty, not a sale
+};
+
+struct OrderLogRecord {
+    OrderLogType type;
+    Order order;
+};
+
+struct OrderLogReplay {
+    long long records = 0;
+    long long validBytes = 0;
+    long long discardedBytes = 0;   // torn or corrupt tail
+};
+
+class OrderLog {
+    int fd = -1;
+    bool groupCommit;
+    chrono::microseconds window;
+    static constexpr size_t MAX_BATCH_BYTES = 1 << 20;   // flush early past this
+
+    mutex m;
+    condition_variable work, durable;
+    vector<uint8_t> pending, writing;
+    uint64_t appendedLsn = 0, durableLsn = 0;   // LSN = bytes appended since open
+    int failure = 0;   // errno of the first failed open/write/sync; sticky, nothing is durable past it
+    long long flushes = 0, records = 0;
+    bool stopping = false;
+    thread flusher;
+
+    static void encode(const OrderLogRecord &r, vector<uint8_t> &out) {
+        const Order &o = r.order;
+        uint16_t nameLen = min<size_t>(o.customer.size(), UINT16_MAX);
+        uint32_t len = 1 + 4 * 4 + 2 + nameLen;
+        size_t start = out.size();
+        out.resize(start + 8 + len);
+        uint8_t *p = out.data() + start + 8;
+        *p++ = (uint8_t)r.type;
+        for (int32_t v : {o.orderId, o.itemId, o.qty, o.timestampHour}) { memcpy(p, &v, 4); p += 4; }
+        memcpy(p, &nameLen, 2);
+        memcpy(p + 2, o.customer.data(), nameLen);
+        uint32_t crc = crc32c(out.data() + start + 8, len);
+        memcpy(out.data() + start, &len, 4);
+        memcpy(out.data() + start + 4, &crc, 4);
+    }
+    static bool writeAll(int fd, const uint8_t *p, size_t n) {
+        while (n > 0) {
+            ssize_t w = ::write(fd, p, n);
+            if (w < 0) { if (errno == EINTR) continue; return false; }
+            p += w;
+            n -= w;
+        }
+        return true;
+    }
+
+    void fail(int err) {   // call with m held
+        if (!failure) cerr << "order log: write failed (" << strerror(err) << ")\n";
+        failure = err ? err : EIO;
+        pending.clear();
+    }
+
+    void flusherLoop() {
+        unique_lock<mutex> lk(m);
+        while (true) {
+            work.wait(lk, [&] { return stopping || !pending.empty(); });
+            if (pending.empty()) break;   // stopping and nothing left
+            if (window.count() > 0 && !stopping)
+                work.wait_for(lk, window, [&] { return stopping || pending.size() >= MAX_BATCH_BYTES; });
+            if (failure) { pending.clear(); continue; }   // already reported to every waiter
+            swap(pending, writing);
+            uint64_t end = appendedLsn;
+            lk.unlock();
+            bool ok = writeAll(fd, writing.data(), writing.size()) && fdatasync(fd) == 0;
+            int err = errno;
+            writing.clear();
+            lk.lock();
+            if (ok) durableLsn = end;
+            else fail(err);
+            flushes++;
+            durable.notify_all();
+        }
+    }
+
+public:
+    // windowMicros: how long a flush waits for more records to join it. groupCommit =
+    // false writes and syncs every record on its own (the baseline).
+    explicit OrderLog(const string &path, int windowMicros = 200, bool groupCommit = true)
+        : groupCommit(groupCommit), window(windowMicros) {
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd < 0) failure = errno ? errno : EIO;
+        else if (groupCommit) flusher = thread(&OrderLog::flusherLoop, this);
+    }
+    ~OrderLog() {
+        {
+            lock_guard<mutex> lk(m);
+            stopping = true;
+        }
+        work.notify_one();
+        if (flusher.joinable()) flusher.join();
+        if (fd >= 0) ::close(fd);
+    }
+    OrderLog(const OrderLog&) = delete;
+    OrderLog &operator=(const OrderLog&) = delete;
+
+    bool isOpen() const { return fd >= 0; }
+    int error() { lock_guard<mutex> lk(m); return failure; }   // 0 while healthy
+
+    // Buffers a record and returns its LSN; durable once waitDurable(lsn) returns true.
+    // Returns 0 without logging anything once the log has failed.
+    uint64_t append(const OrderLogRecord &r) {
+        unique_lock<mutex> lk(m);
+        if (failure) return 0;
+        records++;
+        if (!groupCommit) {
+            pending.clear();
+            encode(r, pending);
+            appendedLsn += pending.size();
+            flushes++;
+            if (!writeAll(fd, pending.data(), pending.size()) || fdatasync(fd) != 0) { fail(errno); return 0; }
+            durableLsn = appendedLsn;
+            return appendedLsn;
+        }
+        bool wake = pending.empty();
+        size_t before = pending.size();
+        encode(r, pending);
+        appendedLsn += pending.size() - before;
+        if (wake || pending.size() >= MAX_BATCH_BYTES) work.notify_one();
+        return appendedLsn;
+    }
+    // False when the record never reached disk (the log failed first, or lsn is 0)
+    bool waitDurable(uint64_t lsn) {
+        if (lsn == 0) return false;
+        unique_lock<mutex> lk(m);
+        durable.wait(lk, [&] { return durableLsn >= lsn || failure; });
+        return durableLsn >= lsn;
+    }
+    bool commit(const OrderLogRecord &r) { return waitDurable(append(r)); }
+
+    long long flushCount() { lock_guard<mutex> lk(m); return flushes; }
+    long long recordCount() { lock_guard<mutex> lk(m); return records; }
+
+    // Calls apply for every intact record, then truncates a torn tail so appends resume
+    // on a record boundary. A missing file is an empty log.
+    static OrderLogReplay replay(const string &path, const function<void(const OrderLogRecord&)> &apply) {
+        OrderLogReplay rep;
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return rep;
+        vector<uint8_t> buf;
+        uint8_t chunk[1 << 16];
+        for (ssize_t n; (n = ::read(fd, chunk, sizeof chunk)) > 0;) buf.insert(buf.end(), chunk, chunk + n);
+        ::close(fd);
+
+        size_t pos = 0;
+        OrderLogRecord r;
+        while (pos + 8 <= buf.size()) {
+            uint32_t len, crc;
+            memcpy(&len, &buf[pos], 4);
+            memcpy(&crc, &buf[pos + 4], 4);
+            if (len < 19 || pos + 8 + len > buf.size()) break;
+            const uint8_t *p = &buf[pos + 8];
+            if (crc32c(p, len) != crc) break;
+            uint16_t nameLen;
+            memcpy(&nameLen, p + 17, 2);
+            if (19u + nameLen != len) break;
+            r.type = (OrderLogType)p[0];
+            int32_t v[4];
+            memcpy(v, p + 1, 16);
+            r.order = Order(v[0], v[1], v[2], v[3], string((const char*)p + 19, nameLen));
+            apply(r);
+            rep.records++;
+            pos += 8 + len;
+        }
+        rep.validBytes = pos;
+        rep.discardedBytes = buf.size() - pos;
+        if (rep.discardedBytes > 0 && truncate(path.c_str(), pos) != 0)
+            cerr << "order log: cannot truncate torn tail (" << strerror(errno) << ")\n";
+        return rep;
+    }
+};
+
 /* =========================
    Order Processing Pipeline
    ========================= */
@@ -367,40 +1339,114 @@ class OrderManager {
     SimpleQueue<Order> incoming;
     SimpleQueue<Order> processing;
     SimpleStack<Order> failed;
-    int nextOrderId = 1;
+    atomic<int> nextOrderId{1};
+    mutex incomingLock;
+    OrderLog *log = nullptr;    // optional; when set, every state change is logged first
 public:
+    void attachLog(OrderLog *l) { log = l; }
+
+    // Safe to call from several threads; with a log attached the order is durable on
+    // return, and -1 (order not taken) means the log could not make it so
     int placeOrder(int itemId, int qty, int hour, string customer) {
         int oid = nextOrderId++;
-        incoming.push(Order(oid, itemId, qty, hour, customer));
+        Order o(oid, itemId, qty, hour, move(customer));
+        if (log && !log->commit({OrderLogType::Placed, o})) return -1;
+        lock_guard<mutex> lk(incomingLock);
+        incoming.push(o);
         return oid;
     }
+    // The log* calls return false when a record could not be made durable
+    bool logRestock(int itemId, int qty) {
+        return !log || log->commit({OrderLogType::Restock, Order(0, itemId, qty, 0, "")});
+    }
+    bool logWriteOff(int itemId, int qty) {
+        return !log || log->commit({OrderLogType::WriteOff, Order(0, itemId, qty, 0, "")});
+    }
+    // Sales made outside the pipeline (bulk engine), one record per item
+    bool logBulkSales(const vector<pair<int, int>> &itemQty, int hour) {
+        if (!log || itemQty.empty()) return true;
+        uint64_t lsn = 0;
+        for (auto &iq : itemQty) lsn = log->append({OrderLogType::Fulfilled, Order(0, iq.first, iq.second, hour, "")});
+        return log->waitDurable(lsn);
+    }
+
+    // Rebuilds stock/soldToday, the backorder list and unprocessed orders from the log.
+    // Call before attachLog, on a catalog holding the start-of-day state.
+    OrderLogReplay recover(const string &path, ItemCatalog &catalog, PricingEngine &pricing) {
+        map<int, Order> open;   // placed, not yet fulfilled or failed
+        int maxId = 0;
+        OrderLogReplay rep = OrderLog::replay(path, [&](const OrderLogRecord &r) {
+            const Order &o = r.order;
+            maxId = max(maxId, o.orderId);
+            int slot = catalog.slotOf(o.itemId);
+            switch (r.type) {
+                case OrderLogType::Placed: open[o.orderId] = o; break;
+                case OrderLogType::Fulfilled:
+                    open.erase(o.orderId);
+                    if (slot >= 0) pricing.recordSale(slot, o.qty);
+                    break;
+                case OrderLogType::Failed:   // carries the whole order, placed here or by the bulk engine
+                    open.erase(o.orderId);
+                    failed.push(o);
+                    break;
+                case OrderLogType::Restock:
+                    if (slot >= 0) pricing.restock(slot, o.qty);
+                    break;
+                case OrderLogType::WriteOff:
+                    if (slot >= 0) pricing.writeOff(slot, o.qty);
+                    break;
+            }
+        });
+        for (auto &kv : open) incoming.push(kv.second);
+        nextOrderId = max(nextOrderId.load(), maxId + 1);
+        return rep;
+    }
+
     void moveToProcessing() {
+        lock_guard<mutex> lk(incomingLock);
         while (!incoming.empty()) {
             processing.push(incoming.front());
             incoming.pop();
         }
     }
-    void processOrders(ItemCatalog &catalog, priority_queue<Item, vector<Item>, DemandComparator> &demandHeap) {
+    void processOrders(ItemCatalog &catalog, DemandHeap &demandHeap, PricingEngine &pricing) {
+        uint64_t lsn = 0;   // outcomes of the whole pass share one group commit
         while (!processing.empty()) {
             Order o = processing.front(); processing.pop();
-            Item *it = catalog.getById(o.itemId);
-            if (!it) {
+            int slot = catalog.slotOf(o.itemId);
+            if (slot < 0) {
                 // failed: item not found
+                if (log) lsn = log->append({OrderLogType::Failed, o});
                 failed.push(o);
                 continue;
             }
-            if (it->stock >= o.qty) {
-                it->stock -= o.qty;
-                it->soldToday += o.qty;
-                // update demand heap: push updated copy (heap contains copies)
-                demandHeap.push(*it);
-                cout << "Order " << o.orderId << " fulfilled for item " << it->name << " qty " << o.qty << "\n";
+            CatalogColumns &c = catalog.columns();
+            if (c.stock[slot] >= o.qty) {
+                if (log) lsn = log->append({OrderLogType::Fulfilled, o});
+                pricing.recordSale(slot, o.qty);
+                // update demand heap in place (keyed by slot, no copies)
+                demandHeap.set(slot, c.soldToday[slot]);
+                cout << "Order " << o.orderId << " fulfilled for item " << c.name[slot] << " qty " << o.qty << "\n";
             } else {
-                cout << "Order " << o.orderId << " partial/failed for item " << it->name << " (stock " << it->stock << ")\n";
+                cout << "Order " << o.orderId << " partial/failed for item " << c.name[slot] << " (stock " << c.stock[slot] << ")\n";
                 // push failed (simulate backorder)
+                if (log) lsn = log->append({OrderLogType::Failed, o});
                 failed.push(o);
             }
         }
+        if (log && (log->error() || (lsn && !log->waitDurable(lsn))))
+            cout << "Warning: order log failed, outcomes of this pass are not durable.\n";
+    }
+    // Lines the bulk engine could not cover join the backorder list under fresh order ids,
+    // logged as failures like the pipeline's own; false when they could not be made durable
+    bool addBackorders(const vector<OrderLine> &lines, const CatalogColumns &c, int hour) {
+        uint64_t lsn = 0;
+        for (const OrderLine &l : lines) {
+            Order o(nextOrderId++, l.slot >= 0 && l.slot < c.size() ? c.id[l.slot] : -1, l.qty, hour, "bulk");
+            if (log) lsn = log->append({OrderLogType::Failed, o});
+            failed.push(o);
+        }
+        return !log || lines.empty() || log->waitDurable(lsn);
     }
     void printFailed() {
         cout << "*** Failed / backorder list (LIFO) ***\n";
@@ -416,6 +1462,682 @@ public:
     }
 };
 
+/* =========================
+   Concurrent Order Engine
+   ========================= */
+
+struct OrderBatch {
+    static constexpr int CAPACITY = 64;
+    int count = 0;
+    OrderLine lines[CAPACITY];
+};
+
+// Bounded lock-free MPMC ring (Vyukov): each cell carries a sequence number that tells
+// producers and consumers whose turn it is, so push/pop are one CAS on the shared index.
+template<typename T>
+class MPMCQueue {
+    struct Cell {
+        atomic<size_t> seq;
+        T data;
+    };
+    vector<Cell> cells;
+    size_t mask;
+    alignas(64) atomic<size_t> enqueuePos{0};
+    alignas(64) atomic<size_t> dequeuePos{0};
+public:
+    explicit MPMCQueue(size_t capacity) {   // rounded up to a power of two
+        size_t cap = 2;
+        while (cap < capacity) cap <<= 1;
+        cells = vector<Cell>(cap);
+        mask = cap - 1;
+        for (size_t i = 0; i < cap; ++i) cells[i].seq.store(i, memory_order_relaxed);
+    }
+    bool tryPush(const T &v) {
+        size_t pos = enqueuePos.load(memory_order_relaxed);
+        while (true) {
+            Cell &cell = cells[pos & mask];
+            intptr_t diff = (intptr_t)cell.seq.load(memory_order_acquire) - (intptr_t)pos;
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                    cell.data = v;
+                    cell.seq.store(pos + 1, memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;   // full
+            } else {
+                pos = enqueuePos.load(memory_order_relaxed);
+            }
+        }
+    }
+    bool tryPop(T &out) {
+        size_t pos = dequeuePos.load(memory_order_relaxed);
+        while (true) {
+            Cell &cell = cells[pos & mask];
+            intptr_t diff = (intptr_t)cell.seq.load(memory_order_acquire) - (intptr_t)(pos + 1);
+            if (diff == 0) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                    out = cell.data;
+                    cell.seq.store(pos + mask + 1, memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;   // empty
+            } else {
+                pos = dequeuePos.load(memory_order_relaxed);
+            }
+        }
+    }
+};
+
+// Workers pull whole batches from the MPMC queue and reserve stock with a CAS on a
+// per-item atomic counter, so no lock is held and no Item pointer is ever shared.
+// Orders that cannot be covered go to a lock-free backorder stack (one push per batch).
+class ConcurrentOrderEngine {
+    struct BackorderNode {
+        vector<OrderLine> lines;
+        BackorderNode *next = nullptr;
+    };
+
+    int n;
+    unique_ptr<atomic<int>[]> stock;
+    unique_ptr<atomic<int>[]> sold;
+    MPMCQueue<OrderBatch> queue;
+    atomic<BackorderNode*> backorders{nullptr};
+    atomic<bool> closed{false};
+    atomic<long long> fulfilled{0}, failedCount{0}, unitsSold{0};
+    vector<thread> workers;
+
+    bool reserve(int slot, int qty) {
+        int s = stock[slot].load(memory_order_relaxed);
+        while (s >= qty)
+            if (stock[slot].compare_exchange_weak(s, s - qty, memory_order_acq_rel, memory_order_relaxed)) return true;
+        return false;
+    }
+
+    void workerLoop() {
+        OrderBatch batch;
+        vector<OrderLine> failedLines;
+        long long ok = 0, units = 0;
+        while (true) {
+            if (!queue.tryPop(batch)) {
+                if (!closed.load(memory_order_acquire)) { this_thread::yield(); continue; }
+                if (!queue.tryPop(batch)) break;   // closed and drained
+            }
+            for (int i = 0; i < batch.count; ++i) {
+                const OrderLine &o = batch.lines[i];
+                if (o.slot >= 0 && o.slot < n && o.qty > 0 && reserve(o.slot, o.qty)) {
+                    sold[o.slot].fetch_add(o.qty, memory_order_relaxed);
+                    ok++; units += o.qty;
+                } else {
+                    failedLines.push_back(o);
+                }
+            }
+            batch.count = 0;
+            if (!failedLines.empty()) {
+                failedCount.fetch_add(failedLines.size(), memory_order_relaxed);
+                auto *node = new BackorderNode{move(failedLines)};
+                node->next = backorders.load(memory_order_relaxed);
+                while (!backorders.compare_exchange_weak(node->next, node, memory_order_release, memory_order_relaxed)) {}
+                failedLines = {};
+            }
+        }
+        fulfilled.fetch_add(ok, memory_order_relaxed);
+        unitsSold.fetch_add(units, memory_order_relaxed);
+    }
+
+public:
+    ConcurrentOrderEngine(const CatalogColumns &c, int workerCount, size_t queueBatches = 1024)
+        : n(c.size()), stock(new atomic<int>[c.size()]), sold(new atomic<int>[c.size()]), queue(queueBatches) {
+        for (int i = 0; i < n; ++i) {
+            stock[i].store(c.stock[i], memory_order_relaxed);
+            sold[i].store(c.soldToday[i], memory_order_relaxed);
+        }
+        for (int w = 0; w < max(1, workerCount); ++w) workers.emplace_back(&ConcurrentOrderEngine::workerLoop, this);
+    }
+    ~ConcurrentOrderEngine() {
+        finish();
+        for (BackorderNode *p = backorders.exchange(nullptr); p; ) { BackorderNode *nx = p->next; delete p; p = nx; }
+    }
+
+    // Safe from any number of producer threads; spins while the ring is full
+    void submit(const OrderBatch &batch) {
+        while (!queue.tryPush(batch)) this_thread::yield();
+    }
+
+    // Call once every submit() has returned: workers drain the queue and exit
+    void finish() {
+        closed.store(true, memory_order_release);
+        for (auto &t : workers) if (t.joinable()) t.join();
+    }
+
+    long long fulfilledOrders() const { return fulfilled.load(); }
+    long long backorderedOrders() const { return failedCount.load(); }
+    long long units() const { return unitsSold.load(); }
+
+    // Takes every backordered line accumulated so far (oldest batch first)
+    vector<OrderLine> drainBackorders() {
+        vector<BackorderNode*> nodes;
+        for (BackorderNode *p = backorders.exchange(nullptr, memory_order_acquire); p; p = p->next) nodes.push_back(p);
+        vector<OrderLine> out;
+        for (auto it = nodes.rbegin(); it != nodes.rend(); ++it) {
+            out.insert(out.end(), (*it)->lines.begin(), (*it)->lines.end());
+            delete *it;
+        }
+        return out;
+    }
+
+    // After finish(): write counters back to the catalog and mark moved items dirty for repricing
+    void commit(CatalogColumns &c, PricingEngine *pricing = nullptr) {
+        for (int i = 0; i < n; ++i) {
+            int s = stock[i].load(memory_order_relaxed);
+            if (s == c.stock[i]) continue;
+            c.stock[i] = s;
+            c.soldToday[i] = sold[i].load(memory_order_relaxed);
+            if (pricing) pricing->markDirty(i);
+        }
+    }
+};
+
+/* =========================
+   Price History Store
+   ========================= */
+
+// Append-only hourly price history per catalog slot, Gorilla-encoded: timestamps as
+// delta-of-delta (a steady hourly cadence costs one bit) and prices as the XOR of
+// consecutive values in cents (an unchanged price costs one bit, a change a dozen or two).
+// Active series live in memory; every segmentHours they are sealed into an immutable
+// segment file that is read back through mmap.
+
+// Bits are packed LSB-first into 64-bit words
+struct BitWriter {
+    vector<uint64_t> words;
+    uint64_t bits = 0;
+
+    void write(uint64_t value, int n) {   // low n bits of value, 1 <= n <= 64
+        if (n < 64) value &= (1ULL << n) - 1;
+        int used = bits & 63;
+        if (used == 0) words.push_back(0);
+        words.back() |= value << used;
+        if (used + n > 64) words.push_back(value >> (64 - used));
+        bits += n;
+    }
+};
+
+struct BitReader {
+    const uint64_t *words;
+    uint64_t pos = 0;
+
+    uint64_t read(int n) {
+        size_t w = pos >> 6;
+        int off = pos & 63;
+        uint64_t v = words[w] >> off;
+        if (off + n > 64) v |= words[w + 1] << (64 - off);
+        pos += n;
+        return n == 64 ? v : v & ((1ULL << n) - 1);
+    }
+    bool bit() { return read(1); }
+};
+
+inline int64_t signExtend(uint64_t v, int n) { return (int64_t)(v << (64 - n)) >> (64 - n); }
+
+inline uint64_t centsBits(double price) {
+    double cents = round(price * 100.0);   // prices are already rounded to 2 decimals
+    uint64_t bits;
+    memcpy(&bits, &cents, sizeof bits);
+    return bits;
+}
+
+// Delta-of-delta buckets: '0' | '10'+7 | '110'+9 | '1110'+12 | '1111'+32 bits
+struct PriceSeriesEncoder {
+    BitWriter out;
+    int count = 0;
+    int firstHour = 0, lastHour = 0, lastDelta = 1;
+    uint64_t lastBits = 0;
+    int leading = -1, trailing = 0;     // XOR window of the previous change, -1 = none yet
+
+    // Hours must strictly increase; returns false otherwise
+    bool append(int hour, double price) {
+        uint64_t bits = centsBits(price);
+        if (count == 0) {
+            out.write((uint32_t)hour, 32);
+            out.write(bits, 64);
+            firstHour = hour;
+        } else {
+            if (hour <= lastHour) return false;
+            int delta = hour - lastHour;
+            int64_t dod = (int64_t)delta - lastDelta;
+            if (dod == 0) out.write(0, 1);
+            else if (dod >= -64 && dod < 64) { out.write(0b01, 2); out.write(dod, 7); }
+            else if (dod >= -256 && dod < 256) { out.write(0b011, 3); out.write(dod, 9); }
+            else if (dod >= -2048 && dod < 2048) { out.write(0b0111, 4); out.write(dod, 12); }
+            else { out.write(0b1111, 4); out.write(dod, 32); }
+            lastDelta = delta;
+
+            uint64_t x = bits ^ lastBits;
+            if (x == 0) out.write(0, 1);
+            else {
+                int lead = min(__builtin_clzll(x), 31), trail = __builtin_ctzll(x);
+                if (leading >= 0 && lead >= leading && trail >= trailing) {
+                    out.write(0b01, 2);                             // reuse previous window
+                    out.write(x >> trailing, 64 - leading - trailing);
+                } else {
+                    int len = 64 - lead - trail;
+                    out.write(0b11, 2);
+                    out.write(lead, 5);
+                    out.write(len & 63, 6);                         // 64 is stored as 0
+                    out.write(x >> trail, len);
+                    leading = lead;
+                    trailing = trail;
+                }
+            }
+        }
+        lastHour = hour;
+        lastBits = bits;
+        count++;
+        return true;
+    }
+};
+
+class PriceSeriesDecoder {
+    BitReader in;
+    int remaining;
+    int hour = 0, delta = 1;
+    uint64_t bits = 0;
+    int leading = 0, trailing = 0;
+    bool first = true;
+public:
+    PriceSeriesDecoder(const uint64_t *words, int count) : in{words}, remaining(count) {}
+
+    bool next(int &hourOut, double &priceOut) {
+        if (remaining == 0) return false;
+        remaining--;
+        if (first) {
+            first = false;
+            hour = (int32_t)in.read(32);
+            bits = in.read(64);
+        } else {
+            int64_t dod;
+            if (!in.bit()) dod = 0;
+            else if (!in.bit()) dod = signExtend(in.read(7), 7);
+            else if (!in.bit()) dod = signExtend(in.read(9), 9);
+            else if (!in.bit()) dod = signExtend(in.read(12), 12);
+            else dod = signExtend(in.read(32), 32);
+            delta += (int)dod;
+            hour += delta;
+            if (in.bit()) {
+                if (in.bit()) {
+                    leading = in.read(5);
+                    int len = in.read(6);
+                    if (len == 0) len = 64;
+                    trailing = 64 - leading - len;
+                }
+                bits ^= in.read(64 - leading - trailing) << trailing;
+            }
+        }
+        double cents;
+        memcpy(&cents, &bits, sizeof cents);
+        hourOut = hour;
+        priceOut = cents / 100.0;
+        return true;
+    }
+};
+
+// Segment file: Header, one SeriesIndex per slot, then every series' words back to back
+class PriceSegment {
+public:
+    struct Header {
+        uint32_t magic;
+        uint32_t slots;
+        int32_t firstHour, lastHour;
+        uint64_t words;
+    };
+    struct SeriesIndex {
+        int32_t firstHour, lastHour;
+        int32_t count, pad;
+        uint64_t wordOffset;
+    };
+    static constexpr uint32_t MAGIC = 0x31534850;   // "PHS1"
+
+    static bool write(const string &path, const vector<PriceSeriesEncoder> &series, int firstHour, int lastHour) {
+        Header h{MAGIC, (uint32_t)series.size(), firstHour, lastHour, 0};
+        vector<SeriesIndex> index(series.size());
+        for (size_t s = 0; s < series.size(); ++s) {
+            const PriceSeriesEncoder &e = series[s];
+            index[s] = {e.firstHour, e.lastHour, e.count, 0, h.words};
+            h.words += e.out.words.size();
+        }
+        FILE *f = fopen(path.c_str(), "wb");
+        if (!f) return false;
+        bool ok = fwrite(&h, sizeof h, 1, f) == 1
+               && fwrite(index.data(), sizeof(SeriesIndex), index.size(), f) == index.size();
+        for (size_t s = 0; s < series.size() && ok; ++s) {
+            const vector<uint64_t> &w = series[s].out.words;
+            ok = fwrite(w.data(), sizeof(uint64_t), w.size(), f) == w.size();
+        }
+        return fclose(f) == 0 && ok;
+    }
+
+    // nullptr when the file is missing or not a segment
+    static unique_ptr<PriceSegment> open(const string &path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return nullptr;
+        struct stat st;
+        void *map = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(Header))
+            map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (map == MAP_FAILED) return nullptr;
+        unique_ptr<PriceSegment> seg(new PriceSegment(map, st.st_size));
+        const Header &h = seg->header();
+        size_t need = sizeof(Header) + h.slots * sizeof(SeriesIndex) + h.words * sizeof(uint64_t);
+        if (h.magic != MAGIC || need != seg->length) return nullptr;
+        return seg;
+    }
+
+    ~PriceSegment() { munmap(base, length); }
+    PriceSegment(const PriceSegment&) = delete;
+    PriceSegment &operator=(const PriceSegment&) = delete;
+
+    int firstHour() const { return header().firstHour; }
+    int lastHour() const { return header().lastHour; }
+    int slots() const { return header().slots; }
+    size_t bytes() const { return length; }
+    const SeriesIndex &index(int slot) const {
+        return reinterpret_cast<const SeriesIndex*>((const char*)base + sizeof(Header))[slot];
+    }
+    PriceSeriesDecoder series(int slot) const {
+        const uint64_t *words = reinterpret_cast<const uint64_t*>(
+            (const char*)base + sizeof(Header) + slots() * sizeof(SeriesIndex));
+        return PriceSeriesDecoder(words + index(slot).wordOffset, index(slot).count);
+    }
+
+private:
+    void *base;
+    size_t length;
+    PriceSegment(void *b, size_t len) : base(b), length(len) {}
+    const Header &header() const { return *reinterpret_cast<const Header*>(base); }
+};
+
+struct PriceStats {
+    int count = 0;
+    double minPrice = 0, maxPrice = 0, sum = 0;
+    double mean() const { return count ? sum / count : 0.0; }
+    void add(double p) {
+        if (count == 0 || p < minPrice) minPrice = p;
+        if (count == 0 || p > maxPrice) maxPrice = p;
+        sum += p;
+        count++;
+    }
+};
+
+class PriceHistoryStore {
+    string dir;
+    int segmentHours;
+    vector<unique_ptr<PriceSegment>> segments;   // sealed, in time order
+    vector<PriceSeriesEncoder> active;
+    int activeFirst = INT_MAX, activeLast = INT_MIN;
+    long long samples = 0;
+
+    template<class Fn>
+    static void scanSeries(PriceSeriesDecoder d, int fromHour, int toHour, Fn &fn) {
+        int h;
+        double p;
+        while (d.next(h, p) && h <= toHour)
+            if (h >= fromHour) fn(h, p);
+    }
+
+public:
+    // Segment files go to directory (created on the first seal)
+    explicit PriceHistoryStore(string directory, int segmentHours = 24 * 7)
+        : dir(move(directory)), segmentHours(segmentHours) {}
+
+    bool record(int slot, int hour, double price) {
+        if (activeFirst != INT_MAX && hour / segmentHours != activeFirst / segmentHours) seal();
+        if (slot >= (int)active.size()) active.resize(slot + 1);
+        if (!active[slot].append(hour, price)) return false;
+        activeFirst = min(activeFirst, hour);
+        activeLast = max(activeLast, hour);
+        samples++;
+        return true;
+    }
+    // Price of every slot for one hour
+    void recordHour(const CatalogColumns &c, int hour) {
+        for (int slot = 0; slot < c.size(); ++slot) record(slot, hour, c.currentPrice[slot]);
+    }
+
+    // Freezes the active series into a segment file; on I/O failure they stay in memory
+    bool seal() {
+        if (activeFirst == INT_MAX) return true;
+        error_code ec;
+        filesystem::create_directories(dir, ec);
+        string path = dir + "/segment-" + to_string(activeFirst) + "-" + to_string(activeLast) + ".phs";
+        if (!PriceSegment::write(path, active, activeFirst, activeLast)) return false;
+        unique_ptr<PriceSegment> seg = PriceSegment::open(path);
+        if (!seg) return false;
+        segments.push_back(move(seg));
+        int slots = active.size();
+        active.clear();
+        active.resize(slots);
+        activeFirst = INT_MAX;
+        activeLast = INT_MIN;
+        return true;
+    }
+
+    // fn(hour, price) for every sample of slot in [fromHour, toHour], oldest first
+    template<class Fn>
+    void scan(int slot, int fromHour, int toHour, Fn fn) const {
+        for (auto &seg : segments) {
+            if (seg->lastHour() < fromHour || seg->firstHour() > toHour || slot >= seg->slots()) continue;
+            scanSeries(seg->series(slot), fromHour, toHour, fn);
+        }
+        if (slot < (int)active.size() && activeLast >= fromHour && activeFirst <= toHour) {
+            const PriceSeriesEncoder &e = active[slot];
+            scanSeries(PriceSeriesDecoder(e.out.words.data(), e.count), fromHour, toHour, fn);
+        }
+    }
+
+    // Per-slot min/max/mean over [fromHour, toHour], slots split across threads
+    vector<PriceStats> aggregate(int fromHour, int toHour, int threads = 0) const {
+        int n = active.size();
+        for (auto &seg : segments) n = max(n, seg->slots());
+        vector<PriceStats> stats(n);
+        auto work = [&](int begin, int end) {
+            for (int slot = begin; slot < end; ++slot)
+                scan(slot, fromHour, toHour, [&](int, double p) { stats[slot].add(p); });
+        };
+        if (threads <= 0) threads = max(1u, thread::hardware_concurrency());
+        threads = max(1, min(threads, n / 1024));
+        vector<thread> pool;
+        int chunk = (n + threads - 1) / threads;
+        for (int begin = 0; begin < n; begin += chunk) pool.emplace_back(work, begin, min(n, begin + chunk));
+        for (auto &th : pool) th.join();
+        return stats;
+    }
+
+    long long sampleCount() const { return samples; }
+    int segmentCount() const { return segments.size(); }
+    size_t storedBytes() const {
+        size_t b = 0;
+        for (auto &seg : segments) b += seg->bytes();
+        for (auto &e : active) b += e.out.words.size() * sizeof(uint64_t);
+        return b;
+    }
+};
+
+/* =========================
+   Policy Backtester
+   ========================= */
+
+// Replays an order stream through a copy of the catalog, a PricingEngine and the same
+// stock check OrderManager uses, in simulated time, once per pricing policy. The order
+// stream is shared read-only; each policy runs on its own thread with its own columns.
+
+struct ReplayOrder {
+    int32_t hour;   // hours since the start of the stream
+    int32_t slot;
+    int32_t qty;
+};
+
+struct BacktestConfig {
+    double elasticity = 1.5;   // a customer buys with probability min(1, (basePrice / price)^elasticity)
+    int restockHour = 6;       // daily top-up back to the opening stock level
+    int shelfLifeDays = 5;     // expiry given to fresh perishable stock
+};
+
+struct BacktestResult {
+    PricingPolicy policy;
+    double revenue = 0;
+    long long ordersFilled = 0, unitsSold = 0;
+    long long declined = 0;      // customer walked away at the offered price
+    long long stockouts = 0;     // customer would have bought, not enough stock
+    long long wastedUnits = 0;   // perishables that expired on the shelf
+    double wasteValue = 0;       // at base price
+    double seconds = 0;
+};
+
+// Uniform [0, 1) from the order index, identical for every policy
+inline double replayUniform(uint64_t i) {
+    uint64_t z = i + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return ((z ^ (z >> 31)) >> 11) * 0x1.0p-53;
+}
+
+BacktestResult backtestPolicy(const CatalogColumns &opening, const vector<ReplayOrder> &orders,
+                              const PricingPolicy &policy, const BacktestConfig &cfg) {
+    auto t0 = chrono::steady_clock::now();
+    BacktestResult r;
+    r.policy = policy;
+    CatalogColumns c = opening;
+    PricingEngine engine(c, policy);
+    const int n = c.size();
+    const int lastHour = orders.empty() ? -1 : orders.back().hour;
+    size_t next = 0;
+    for (int h = 0; h <= lastHour; ++h) {
+        int hour = h % 24;
+        if (hour == 0 && h > 0) {
+            engine.newDay();
+            for (int slot = 0; slot < n; ++slot)
+                if (c.perishable[slot] && c.expiryDays[slot] == 0 && c.stock[slot] > 0) {
+                    r.wastedUnits += c.stock[slot];
+                    r.wasteValue += c.stock[slot] * c.basePrice[slot];
+                    engine.writeOff(slot, c.stock[slot]);
+                }
+        }
+        if (hour == cfg.restockHour)
+            for (int slot = 0; slot < n; ++slot) {
+                if (c.perishable[slot] && c.expiryDays[slot] == 0) engine.setExpiry(slot, cfg.shelfLifeDays);
+                if (c.stock[slot] < opening.stock[slot]) engine.restock(slot, opening.stock[slot] - c.stock[slot]);
+            }
+        engine.tick(hour);
+
+        for (; next < orders.size() && orders[next].hour == h; ++next) {
+            const ReplayOrder &o = orders[next];
+            double price = c.currentPrice[o.slot];
+            double accept = min(1.0, pow(c.basePrice[o.slot] / price, cfg.elasticity));
+            if (replayUniform(next) >= accept) { r.declined++; continue; }
+            if (c.stock[o.slot] < o.qty) { r.stockouts++; continue; }
+            engine.recordSale(o.slot, o.qty);
+            r.revenue += price * o.qty;
+            r.unitsSold += o.qty;
+            r.ordersFilled++;
+        }
+    }
+    r.seconds = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    return r;
+}
+
+// One policy per thread at a time, policies handed out through a shared counter
+vector<BacktestResult> runBacktests(const CatalogColumns &opening, const vector<ReplayOrder> &orders,
+                                    const vector<PricingPolicy> &policies, const BacktestConfig &cfg = BacktestConfig(),
+                                    int threads = 0) {
+    vector<BacktestResult> results(policies.size());
+    atomic<size_t> nextPolicy{0};
+    auto worker = [&] {
+        for (size_t p; (p = nextPolicy.fetch_add(1)) < policies.size();)
+            results[p] = backtestPolicy(opening, orders, policies[p], cfg);
+    };
+    if (threads <= 0) threads = max(1u, thread::hardware_concurrency());
+    threads = max(1, min(threads, (int)policies.size()));
+    vector<thread> pool;
+    for (int t = 0; t < threads; ++t) pool.emplace_back(worker);
+    for (auto &th : pool) th.join();
+    return results;
+}
+
+// Placed orders from an order log, in log order. Records only carry the hour of day, so a
+// new day starts whenever the hour goes backwards. Unknown items are skipped.
+vector<ReplayOrder> loadOrderStream(const string &logPath, const ItemCatalog &catalog) {
+    vector<ReplayOrder> placed;
+    vector<int> itemIds;
+    int day = 0, lastHour = 0;
+    OrderLog::replay(logPath, [&](const OrderLogRecord &r) {
+        if (r.type != OrderLogType::Placed || r.order.qty <= 0) return;
+        int hour = ((r.order.timestampHour % 24) + 24) % 24;
+        if (hour < lastHour) day++;
+        lastHour = hour;
+        placed.push_back({day * 24 + hour, -1, r.order.qty});
+        itemIds.push_back(r.order.itemId);
+    });
+    vector<int> slots(itemIds.size());
+    catalog.slotsOf(itemIds.data(), itemIds.size(), slots.data());
+    vector<ReplayOrder> orders;
+    for (size_t i = 0; i < placed.size(); ++i)
+        if (slots[i] >= 0) orders.push_back({placed[i].hour, slots[i], placed[i].qty});
+    return orders;
+}
+
+// Synthetic history: Zipf item popularity, lunch and dinner peaks, 1-3 units per order
+vector<ReplayOrder> synthesizeOrderStream(int items, int days, int ordersPerDay, uint32_t seed) {
+    static const double hourWeight[24] = {0.2, 0.1, 0.1, 0.1, 0.1, 0.2, 0.4, 0.8, 1.0, 1.0, 1.2, 2.5,
+                                          3.0, 2.5, 1.2, 1.0, 1.0, 1.2, 1.8, 3.0, 3.2, 2.5, 1.0, 0.5};
+    mt19937 rng(seed);
+    vector<double> itemCdf(items);
+    double sum = 0;
+    for (int i = 0; i < items; ++i) { sum += 1.0 / pow(i + 1, 0.9); itemCdf[i] = sum; }
+    uniform_real_distribution<double> pickItem(0.0, sum);
+    discrete_distribution<int> pickHour(begin(hourWeight), end(hourWeight));
+
+    vector<ReplayOrder> orders;
+    orders.reserve((size_t)days * ordersPerDay);
+    vector<int> perHour(24);
+    for (int d = 0; d < days; ++d) {
+        fill(perHour.begin(), perHour.end(), 0);
+        for (int i = 0; i < ordersPerDay; ++i) perHour[pickHour(rng)]++;
+        for (int h = 0; h < 24; ++h)
+            for (int i = 0; i < perHour[h]; ++i) {
+                int slot = lower_bound(itemCdf.begin(), itemCdf.end(), pickItem(rng)) - itemCdf.begin();
+                orders.push_back({d * 24 + h, min(slot, items - 1), 1 + (int)(rng() % 3)});
+            }
+    }
+    return orders;
+}
+
+// Coarse grid around the live policy
+vector<PricingPolicy> policyGrid() {
+    vector<PricingPolicy> grid;
+    for (double alpha : {0.0, 0.02, 0.05})
+        for (double beta : {0.0005, 0.001})
+            for (double gamma : {0.0, 0.05})
+                for (double delta : {0.05, 0.2})
+                    grid.push_back({alpha, beta, gamma, delta});
+    return grid;
+}
+
+void printBacktestResults(vector<BacktestResult> results, size_t show) {
+    sort(results.begin(), results.end(), [](const BacktestResult &a, const BacktestResult &b) { return a.revenue > b.revenue; });
+    cout << "  alpha   beta    gamma  delta |      revenue   filled  declined  stockouts  wasted (value)\n";
+    for (size_t i = 0; i < min(show, results.size()); ++i) {
+        const BacktestResult &r = results[i];
+        cout << "  " << left << setw(7) << r.policy.alpha << " " << setw(7) << r.policy.beta << " " << setw(6)
+             << r.policy.gamma << " " << setw(5) << r.policy.delta << right << " | " << fixed << setprecision(0)
+             << setw(12) << r.revenue << " " << setw(8) << r.ordersFilled << " " << setw(9) << r.declined << " "
+             << setw(10) << r.stockouts << " " << setw(7) << r.wastedUnits << " (" << r.wasteValue << ")\n"
+             << defaultfloat << setprecision(6);
+    }
+}
+
 /* =========================
    Reporting Utilities
    ========================= */
@@ -425,14 +2147,636 @@ void printItem(const Item &it) {
          << " | Stock: " << it.stock << " | SoldToday: " << it.soldToday << " | ExpiryDays: " << it.expiryDays << "\n";
 }
 
+/* =========================
+   Benchmarks
+   ========================= */
+// Run with: ./dynamic_pricing --bench [name] [size]   (no name = all)
+
+long long benchSize = 0;   // optional third argument, used by benchmarks with a size sweep
+
+double secondsSince(chrono::steady_clock::time_point t0) {
+    return chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+}
+
+void benchIndexedHeaps() {
+    const int N = 10000000, UPDATES = 10000000, K = 10;
+    mt19937 rng(1);
+
+    auto t0 = chrono::steady_clock::now();
+    DemandHeap demand(N);
+    for (int slot = 0; slot < N; ++slot) demand.set(slot, rng() % 1000);
+    double buildSec = secondsSince(t0);
+
+    t0 = chrono::steady_clock::now();
+    for (int i = 0; i < UPDATES; ++i) {
+        int slot = rng() % N;
+        demand.set(slot, demand.keyOf(slot) + 1 + rng() % 3);   // order fulfilled
+    }
+    double updSec = secondsSince(t0);
+
+    vector<int> top;
+    t0 = chrono::steady_clock::now();
+    for (int q = 0; q < 1000; ++q) demand.topK(K, top);
+    double topSec = secondsSince(t0) / 1000;
+
+    cout << "Indexed demand heap, " << N << " slots\n"
+         << "  build " << buildSec * 1e3 << " ms, " << UPDATES / updSec / 1e6 << " M key updates/s, top-" << K
+         << " in " << topSec * 1e6 << " us, footprint " << demand.memoryBytes() / (1 << 20) << " MiB (size stays "
+         << demand.size() << ")\n";
+
+    // Old scheme: a copy pushed per fulfilled order, top-5 by copying the whole heap
+    const int M = 1000000;
+    auto byDemand = [](const Item &a, const Item &b) { return a.soldToday < b.soldToday; };
+    priority_queue<Item, vector<Item>, decltype(byDemand)> copies(byDemand);
+    Item proto(0, "Menu item", 100.0, 50);
+    t0 = chrono::steady_clock::now();
+    for (int i = 0; i < M; ++i) { proto.id = rng() % (M / 10); proto.soldToday = rng() % 1000; copies.push(proto); }
+    double pushSec = secondsSince(t0);
+    t0 = chrono::steady_clock::now();
+    auto tmp = copies;
+    for (int i = 0; i < 5 && !tmp.empty(); ++i) tmp.pop();
+    double copySec = secondsSince(t0);
+    cout << "  priority_queue<Item> copies: " << M / pushSec / 1e6 << " M pushes/s, " << copies.size()
+         << " entries for " << M / 10 << " items, top-5 via heap copy " << copySec * 1e3 << " ms\n";
+}
+
+
+void benchPriceTree() {
+    const int N = benchSize > 0 ? (int)benchSize : 1000000, UPDATES = N, QUERIES = 200000;
+    mt19937 rng(2);
+    uniform_real_distribution<double> priceDist(1.0, 500.0);
+    vector<double> price(N);
+    for (double &p : price) p = round(priceDist(rng) * 100) / 100;
+
+    auto t0 = chrono::steady_clock::now();
+    PriceTree tree;
+    tree.reserve(N);
+    for (int i = 0; i < N; ++i) tree.insert(price[i], i, i);
+    double buildSec = secondsSince(t0);
+
+    t0 = chrono::steady_clock::now();
+    for (int u = 0; u < UPDATES; ++u) {
+        int i = rng() % N;
+        double p = round(priceDist(rng) * 100) / 100;
+        tree.update(price[i], p, i, i);
+        price[i] = p;
+    }
+    double updSec = secondsSince(t0);
+
+    // Brute-force reference over a sorted copy of the keys
+    vector<pair<double, int>> sorted(N);
+    for (int i = 0; i < N; ++i) sorted[i] = {price[i], i};
+    sort(sorted.begin(), sorted.end());
+    vector<double> lo(QUERIES), hi(QUERIES);
+    for (int q = 0; q < QUERIES; ++q) {
+        lo[q] = priceDist(rng);
+        hi[q] = lo[q] + 5.0 * (rng() % 100) / 100;
+    }
+    bool ok = tree.size() == N;
+    for (int q = 0; q < 1000 && ok; ++q) {
+        int k = rng() % N;
+        auto a = lower_bound(sorted.begin(), sorted.end(), make_pair(lo[q], INT_MIN));
+        auto b = upper_bound(sorted.begin(), sorted.end(), make_pair(hi[q], INT_MAX));
+        ok = tree.kth(k) == sorted[k].second && tree.countInRange(lo[q], hi[q]) == (int)(b - a)
+             && tree.rank(sorted[k].first, sorted[k].second) == k;
+    }
+
+    long long sink = 0;
+    t0 = chrono::steady_clock::now();
+    for (int q = 0; q < QUERIES; ++q) sink += tree.kth(rng() % N);
+    double kthSec = secondsSince(t0) / QUERIES;
+    t0 = chrono::steady_clock::now();
+    for (int q = 0; q < QUERIES; ++q) sink += tree.countInRange(lo[q], hi[q]);
+    double countSec = secondsSince(t0) / QUERIES;
+    vector<int> page;
+    t0 = chrono::steady_clock::now();
+    for (int q = 0; q < QUERIES; ++q) { tree.collectRange(lo[q], hi[q], page, 50); sink += page.size(); }
+    double pageSec = secondsSince(t0) / QUERIES;
+    t0 = chrono::steady_clock::now();
+    long long visited = 0;
+    tree.forEachInOrder([&](double, int, int slot) { visited += slot; });
+    double walkSec = secondsSince(t0);
+
+    cout << "Price tree (pooled AVL, (price,id) keys), " << N << " items, height " << tree.height()
+         << (ok ? "" : "  (MISMATCH vs sorted reference)") << "\n"
+         << "  build " << buildSec * 1e3 << " ms, " << UPDATES / updSec / 1e6 << " M reprices/s, footprint "
+         << tree.memoryBytes() / (1 << 20) << " MiB\n"
+         << "  k-th " << kthSec * 1e9 << " ns, range count " << countSec * 1e9 << " ns, first 50 in range "
+         << pageSec * 1e9 << " ns, full in-order walk " << walkSec * 1e3 << " ms\n";
+
+    // Node-per-item tree, range answered by walking the range (the old in-order approach)
+    t0 = chrono::steady_clock::now();
+    set<pair<double, int>> nodes;
+    for (int i = 0; i < N; ++i) nodes.insert({price[i], i});
+    double setBuildSec = secondsSince(t0);
+    const int SET_QUERIES = 2000;
+    t0 = chrono::steady_clock::now();
+    for (int q = 0; q < SET_QUERIES; ++q)
+        sink += distance(nodes.lower_bound({lo[q], INT_MIN}), nodes.upper_bound({hi[q], INT_MAX}));
+    double setCountSec = secondsSince(t0) / SET_QUERIES;
+    t0 = chrono::steady_clock::now();
+    for (int q = 0; q < SET_QUERIES / 20; ++q) sink += next(nodes.begin(), rng() % N)->second;
+    double setKthSec = secondsSince(t0) / (SET_QUERIES / 20);
+    cout << "  std::set baseline: build " << setBuildSec * 1e3 << " ms, range count " << setCountSec * 1e9
+         << " ns, k-th " << setKthSec * 1e9 << " ns  (checksum " << (sink + visited) % 1000 << ")\n";
+}
+
+void benchIdIndex() {
+    const int N = benchSize > 0 ? (int)benchSize : 10000000, Q = 2000000;
+    mt19937 rng(9);
+    vector<int> ids(N);
+    for (int i = 0; i < N; ++i) ids[i] = i * 4 + rng() % 4;   // sorted, unique, sparse
+    vector<int> idColumn = ids;
+    shuffle(idColumn.begin(), idColumn.end(), rng);          // catalog slot order is arbitrary
+    vector<int> queries(Q);
+    for (int &q : queries) q = rng() % 10 == 0 ? (int)(rng() % (4LL * N)) : idColumn[rng() % N];   // ~90%+ hits
+
+    // Reference answers: slot of each query id
+    unordered_map<int, int> hash;
+    hash.reserve(N);
+    for (int slot = 0; slot < N; ++slot) hash[idColumn[slot]] = slot;
+    vector<int> expect(Q), got(Q);
+    auto t0 = chrono::steady_clock::now();
+    for (int q = 0; q < Q; ++q) { auto it = hash.find(queries[q]); expect[q] = it == hash.end() ? -1 : it->second; }
+    double hashSec = secondsSince(t0);
+
+    t0 = chrono::steady_clock::now();
+    StaticIdIndex index;
+    index.rebuild(idColumn);
+    double buildSec = secondsSince(t0);
+    t0 = chrono::steady_clock::now();
+    for (int q = 0; q < Q; ++q) got[q] = index.find(queries[q]);
+    double singleSec = secondsSince(t0);
+    bool singleOk = got == expect;
+    t0 = chrono::steady_clock::now();
+    const int BATCH = 4096;
+    for (int q = 0; q < Q; q += BATCH) index.findBatch(&queries[q], min(BATCH, Q - q), &got[q]);
+    double batchSec = secondsSince(t0);
+    bool batchOk = got == expect;
+
+    // The existing search: sorted Items, key through std::function on every probe
+    vector<Item> sortedItems(N);
+    for (int i = 0; i < N; ++i) sortedItems[i].id = ids[i];
+    long long found = 0;
+    t0 = chrono::steady_clock::now();
+    for (int q = 0; q < Q; ++q) found += binarySearchIndex(sortedItems, [](const Item &it) { return it.id; }, queries[q]) >= 0;
+    double bsSec = secondsSince(t0);
+
+    t0 = chrono::steady_clock::now();
+    long long found2 = 0;
+    for (int q = 0; q < Q; ++q) found2 += binary_search(ids.begin(), ids.end(), queries[q]);
+    double lbSec = secondsSince(t0);
+
+    auto ns = [&](double sec) { return sec / Q * 1e9; };
+    cout << "Id index, " << N << " keys, " << Q << " lookups (" << found << " hits)\n"
+         << "  binarySearchIndex (vector<Item>, std::function) : " << ns(bsSec) << " ns\n"
+         << "  std::binary_search on dense int ids             : " << ns(lbSec) << " ns" << (found2 == found ? "" : "  (MISMATCH)") << "\n"
+         << "  unordered_map<int,int>::find                    : " << ns(hashSec) << " ns\n"
+         << "  S-tree find, one at a time                      : " << ns(singleSec) << " ns" << (singleOk ? "" : "  (MISMATCH)") << "\n"
+         << "  S-tree findBatch, " << BATCH << " per call                 : " << ns(batchSec) << " ns" << (batchOk ? "" : "  (MISMATCH)") << "\n"
+         << "  S-tree build " << buildSec * 1e3 << " ms, " << index.memoryBytes() / (1 << 20) << " MiB\n";
+}
+
+enum class InputOrder { Random, Sorted, Reversed };
+
+vector<SortKey> makeSortInput(int n, InputOrder order, mt19937 &rng) {
+    vector<SortKey> v(n);
+    uniform_real_distribution<double> price(1.0, 500.0);
+    for (int i = 0; i < n; ++i) v[i] = {price(rng), i};
+    if (order == InputOrder::Sorted) sort(v.begin(), v.end(), SortKeyLess());
+    if (order == InputOrder::Reversed) sort(v.begin(), v.end(), SortKeyGreater());
+    return v;
+}
+
+void benchSorting() {
+    vector<int> sizes = {1000000, 10000000};
+    if (benchSize > 10000000) sizes.push_back((int)benchSize);   // e.g. --bench sort 50000000
+    const pair<const char*, InputOrder> orders[] = {
+        {"random", InputOrder::Random}, {"sorted", InputOrder::Sorted}, {"reversed", InputOrder::Reversed}
+    };
+    mt19937 rng(2);
+    cout << "Sort kernels on (price, slot) keys, ms\n";
+    cout << "  n          input     introsort  mergesort  heapsort  std::sort  std::stable_sort\n";
+    const ios::fmtflags savedFlags = cout.flags();
+    const streamsize savedPrecision = cout.precision();
+    for (int n : sizes) {
+        for (auto &[name, order] : orders) {
+            vector<SortKey> input = makeSortInput(n, order, rng);
+            auto timeIt = [&](auto sorter) {
+                vector<SortKey> v = input;
+                auto t0 = chrono::steady_clock::now();
+                sorter(v);
+                double ms = secondsSince(t0) * 1e3;
+                if (!is_sorted(v.begin(), v.end(), SortKeyLess())) ms = -1;
+                return ms;
+            };
+            double q = timeIt([](vector<SortKey> &v){ quickSort(v, 0, (int)v.size()-1, SortKeyLess()); });
+            double m = timeIt([](vector<SortKey> &v){ mergeSort(v, 0, (int)v.size()-1, SortKeyLess()); });
+            double h = timeIt([](vector<SortKey> &v){ heapSort(v, SortKeyLess()); });
+            double ss = timeIt([](vector<SortKey> &v){ sort(v.begin(), v.end(), SortKeyLess()); });
+            double st = timeIt([](vector<SortKey> &v){ stable_sort(v.begin(), v.end(), SortKeyLess()); });
+            cout << "  " << left << setw(10) << n << " " << setw(9) << name << right << fixed << setprecision(1)
+                 << setw(10) << q << setw(11) << m << setw(10) << h << setw(11) << ss << setw(18) << st << "\n";
+            cout.flags(savedFlags);
+            cout.precision(savedPrecision);
+        }
+    }
+
+    // Whole-Item sorting for comparison (what the menu used to do)
+    const int itemsN = 1000000;
+    vector<Item> items(itemsN, Item(0, "Menu item", 100.0, 50));
+    for (int i = 0; i < itemsN; ++i) { items[i].id = i; items[i].currentPrice = rng() % 50000 / 100.0; }
+    vector<SortKey> keys(itemsN);
+    for (int i = 0; i < itemsN; ++i) keys[i] = {items[i].currentPrice, i};
+    auto t0 = chrono::steady_clock::now();
+    quickSort(items, 0, itemsN-1, [](const Item &a, const Item &b){ return a.currentPrice < b.currentPrice; });
+    double itemMs = secondsSince(t0) * 1e3;
+    t0 = chrono::steady_clock::now();
+    quickSort(keys, 0, itemsN-1, SortKeyLess());
+    double keyMs = secondsSince(t0) * 1e3;
+    cout << "  1M rows introsort: whole Items " << itemMs << " ms vs (key, slot) pairs " << keyMs << " ms\n";
+}
+
+
+void benchRepricing() {
+    const int N = benchSize > 0 ? (int)benchSize : 20000000, ROWS = 2000000, HOUR = 12;
+    mt19937 rng(3);
+    CatalogColumns c;
+    c.reserve(N);
+    Item proto(0, "", 0.0, 0);
+    for (int i = 0; i < N; ++i) {
+        proto.id = i;
+        proto.basePrice = 20 + rng() % 48000 / 100.0;
+        proto.stock = rng() % 500;
+        proto.soldToday = rng() % 300;
+        proto.perishable = rng() % 2;
+        proto.expiryDays = rng() % 30;
+        c.append(proto);
+    }
+
+    // Row-at-a-time scalar path on a 2M-item sample (what menu option 4 did per item)
+    vector<Item> rows;
+    rows.reserve(ROWS);
+    for (int i = 0; i < ROWS; ++i) rows.push_back(c.row(i));
+    auto t0 = chrono::steady_clock::now();
+    for (auto &it : rows) { it.currentPrice = computeDynamicPrice(it, HOUR); it.lastUpdateHour = HOUR; }
+    double rowSec = secondsSince(t0);
+
+    auto timeKernel = [&](RepriceKernel k, int threads) {
+        auto t = chrono::steady_clock::now();
+        repriceCatalog(c, HOUR, threads, k);
+        double sec = secondsSince(t);
+        int mismatches = 0;   // columns must agree exactly with computeDynamicPrice
+        for (int i = 0; i < ROWS; ++i) if (rows[i].currentPrice != c.currentPrice[i]) mismatches++;
+        return make_pair(sec, mismatches);
+    };
+    vector<pair<string, RepriceKernel>> kernels = {{"scalar", repriceRangeScalar}};
+#ifdef PRICING_X86
+    if (__builtin_cpu_supports("avx2")) kernels.push_back({"avx2", repriceRangeAVX2});
+    if (__builtin_cpu_supports("avx512f")) kernels.push_back({"avx512f", repriceRangeAVX512});
+#endif
+
+    cout << "Repricing " << N << " SKUs (" << thread::hardware_concurrency() << " hw threads)\n"
+         << "  row-at-a-time computeDynamicPrice : " << rowSec / ROWS * N * 1e3 << " ms (extrapolated from " << ROWS << ")\n";
+    for (auto &[name, kernel] : kernels) {
+        auto [sec, bad] = timeKernel(kernel, 1);
+        cout << "  columns, " << left << setw(8) << name << right << "1 thread         : " << sec * 1e3 << " ms, "
+             << bad << " prices differ\n";
+    }
+    const char *isa;
+    auto [allSec, allBad] = timeKernel(selectRepriceKernel(&isa), 0);
+    cout << "  columns, " << left << setw(8) << isa << right << "all threads      : " << allSec * 1e3 << " ms, "
+         << allBad << " prices differ\n";
+}
+
+
+void benchIncrementalPricing() {
+    const int N = benchSize > 0 ? (int)benchSize : 20000000;
+    mt19937 rng(4);
+    CatalogColumns c;
+    c.reserve(N);
+    Item proto(0, "", 0.0, 0);
+    for (int i = 0; i < N; ++i) {
+        proto.id = i; proto.basePrice = 20 + rng() % 48000 / 100.0; proto.stock = 100 + rng() % 400;
+        proto.perishable = rng() % 2; proto.expiryDays = rng() % 30;
+        c.append(proto);
+    }
+    cout << "Incremental repricing, " << N << " SKUs, 24 hourly ticks per row\n";
+    vector<double> snapshot;
+    auto runDay = [&](int ordersPerHour, bool subscribe) {
+        PricingEngine engine(c);
+        long long streamed = 0;
+        engine.tick(23);   // prices as published at the end of yesterday (not timed)
+        const PricingTickStats before = engine.cumulative();
+        if (subscribe) engine.subscribe([&](const vector<PriceChange> &ch) { streamed += ch.size(); });
+        double incrementalSec = 0, bandSec = 0, fullSec = 0;
+        for (int hour = 0; hour < 24; ++hour) {
+            for (int i = 0; i < ordersPerHour; ++i) engine.recordSale(rng() % N, 1);
+            PricingTickStats st = engine.tick(hour);
+            incrementalSec += st.micros / 1e6;
+            if (st.bandChanged) bandSec += st.micros / 1e6;
+            if (subscribe) continue;
+
+            // Hourly full reprice, diffed against the old prices to get the same change count
+            auto t0 = chrono::steady_clock::now();
+            snapshot.assign(c.currentPrice.begin(), c.currentPrice.end());
+            repriceCatalog(c, hour);
+            long long moved = 0;
+            for (int i = 0; i < N; ++i) moved += c.currentPrice[i] != snapshot[i];
+            fullSec += secondsSince(t0);
+            if (moved) cout << "  (full reprice moved " << moved << " prices the engine missed)\n";
+        }
+        const PricingTickStats &tot = engine.cumulative();
+        cout << "  " << setw(8) << ordersPerHour << " orders/hour" << (subscribe ? ", streamed" : "") << ": engine "
+             << incrementalSec * 1e3 << " ms (band changes " << bandSec * 1e3 << " ms), repriced "
+             << tot.repriced - before.repriced << ", changed " << tot.changed - before.changed;
+        if (subscribe) cout << ", " << streamed << " events\n";
+        else cout << "; hourly full reprice + diff " << fullSec * 1e3 << " ms\n";
+    };
+    for (int perMillion : {1000, 10000, 100000}) runDay((int)((long long)N * perMillion / 1000000), false);
+    runDay(N / 100, true);
+
+    // A SKU appended between two ticks of the same band is priced by the second one
+    PricingEngine engine(c);
+    engine.tick(0);
+    proto.id = N; proto.basePrice = 99.0; proto.stock = 7; proto.perishable = 1; proto.expiryDays = 1;
+    proto.currentPrice = 0;
+    c.append(proto);
+    engine.tick(1);
+    if (c.currentPrice[N] != computeDynamicPrice(c.row(N), 1) || c.lastUpdateHour[N] != 1)
+        cout << "  (SKU added after the engine started was not priced)\n";
+}
+
+void benchPriceHistory() {
+    const int N = benchSize > 0 ? (int)benchSize : 20000, DAYS = 90, CHECKED = 100;
+    const string dir = (filesystem::temp_directory_path() / "price_history_bench").string();
+    filesystem::remove_all(dir);
+    mt19937 rng(6);
+    CatalogColumns c;
+    c.reserve(N);
+    Item proto(0, "", 0.0, 0);
+    for (int i = 0; i < N; ++i) {
+        proto.id = i; proto.basePrice = 20 + rng() % 48000 / 100.0; proto.stock = 100 + rng() % 400;
+        proto.perishable = rng() % 2; proto.expiryDays = 1 + rng() % 14;
+        c.append(proto);
+    }
+    PricingEngine engine(c);
+    PriceHistoryStore history(dir);
+    vector<vector<pair<int, double>>> reference(CHECKED);   // raw samples of the first slots
+
+    double recordSec = 0;
+    for (int day = 0; day < DAYS; ++day) {
+        engine.newDay();
+        for (int slot = 0; slot < N; ++slot) {
+            if (c.stock[slot] < 100) engine.restock(slot, 300);
+            if (c.perishable[slot] && c.expiryDays[slot] == 0) engine.setExpiry(slot, 14);
+        }
+        for (int hour = 0; hour < 24; ++hour) {
+            for (int i = 0; i < N / 20; ++i) engine.recordSale(rng() % N, 1);
+            engine.tick(hour);
+            int absHour = day * 24 + hour;
+            auto t0 = chrono::steady_clock::now();
+            history.recordHour(c, absHour);
+            recordSec += secondsSince(t0);
+            for (int slot = 0; slot < CHECKED; ++slot) reference[slot].push_back({absHour, c.currentPrice[slot]});
+        }
+    }
+    const int lastHour = DAYS * 24 - 1, from = lastHour - 30 * 24 + 1;
+
+    bool ok = true;
+    for (int slot = 0; slot < CHECKED && ok; ++slot) {
+        size_t i = 0;
+        history.scan(slot, 0, lastHour, [&](int h, double p) {
+            ok = ok && i < reference[slot].size() && reference[slot][i] == make_pair(h, p);
+            i++;
+        });
+        ok = ok && i == reference[slot].size();
+    }
+
+    long long scanned = 0;
+    auto t0 = chrono::steady_clock::now();
+    const int SCANS = 1000;
+    for (int q = 0; q < SCANS; ++q) history.scan(rng() % N, from, lastHour, [&](int, double) { scanned++; });
+    double scanSec = secondsSince(t0) / SCANS;
+
+    long long samples = history.sampleCount();
+    cout << "Price history, " << N << " items x " << DAYS << " days hourly = " << samples << " samples, "
+         << history.segmentCount() << " sealed segments" << (ok ? "" : "  (DECODE MISMATCH)") << "\n"
+         << "  " << (double)history.storedBytes() / samples << " bytes/sample (raw hour+double: 12), record "
+         << samples / recordSec / 1e6 << " M samples/s\n"
+         << "  30-day scan of one item: " << scanSec * 1e6 << " us (" << scanned / SCANS << " samples)\n";
+    for (int threads : {1, 2, 4, 8}) {
+        t0 = chrono::steady_clock::now();
+        vector<PriceStats> stats = history.aggregate(from, lastHour, threads);
+        double aggSec = secondsSince(t0);
+        double meanOfMeans = 0;
+        for (auto &s : stats) meanOfMeans += s.mean() / stats.size();
+        cout << "  30-day min/max/mean for all items, " << threads << " thread(s): " << aggSec * 1e3 << " ms ("
+             << 30 * 24.0 * N / aggSec / 1e6 << " M samples/s, mean price " << meanOfMeans << ")\n";
+    }
+    filesystem::remove_all(dir);
+}
+
+void benchOrderLog() {
+    const int WRITERS = 64;
+    const double SECONDS = benchSize > 0 ? benchSize / 1000.0 : 1.0;   // benchSize in ms
+    const string path = (filesystem::temp_directory_path() / "orders_bench.wal").string();
+    cout << "Order log, " << WRITERS << " writer threads, " << SECONDS << " s per configuration\n";
+
+    struct Config { const char *name; int windowMicros; bool group; };
+    for (Config cfg : {Config{"fsync per order", 0, false}, Config{"group, no window", 0, true},
+                       Config{"group, 100 us", 100, true}, Config{"group, 1 ms", 1000, true},
+                       Config{"group, 5 ms", 5000, true}}) {
+        filesystem::remove(path);
+        atomic<long long> durableOrders{0};
+        atomic<bool> stop{false};
+        double sec;
+        long long flushes;
+        {
+            OrderLog log(path, cfg.windowMicros, cfg.group);
+            OrderManager om;
+            om.attachLog(&log);
+            vector<thread> writers;
+            auto t0 = chrono::steady_clock::now();
+            for (int w = 0; w < WRITERS; ++w)
+                writers.emplace_back([&, w] {
+                    mt19937 rng(w);
+                    while (!stop.load(memory_order_relaxed)) {
+                        om.placeOrder(100 + rng() % 1000, 1 + rng() % 3, 12, "customer");
+                        durableOrders.fetch_add(1, memory_order_relaxed);
+                    }
+                });
+            this_thread::sleep_for(chrono::duration<double>(SECONDS));
+            stop = true;
+            for (auto &t : writers) t.join();
+            sec = secondsSince(t0);
+            flushes = log.flushCount();
+        }
+        cout << "  " << left << setw(18) << cfg.name << right << ": " << setw(9) << (long long)(durableOrders / sec)
+             << " durable orders/s, " << (double)durableOrders / max(1LL, flushes) << " orders per fsync\n";
+    }
+
+    // Recovery: replay a million-sale log into a catalog
+    const int RECORDS = 1000000;
+    filesystem::remove(path);
+    {
+        OrderLog log(path);
+        uint64_t lsn = 0;
+        for (int i = 0; i < RECORDS; ++i)
+            lsn = log.append({OrderLogType::Fulfilled, Order(i + 1, 100 + i % 1000, 1, 12, "customer")});
+        log.waitDurable(lsn);
+    }
+    ItemCatalog catalog;
+    for (int id = 100; id < 1100; ++id) catalog.addOrUpdate(Item(id, "item", 10.0, 1 << 30));
+    PricingEngine pricing(catalog.columns());
+    OrderManager om;
+    auto t0 = chrono::steady_clock::now();
+    OrderLogReplay rep = om.recover(path, catalog, pricing);
+    double recSec = secondsSince(t0);
+    cout << "  recovery: " << rep.records << " records (" << rep.validBytes / (1 << 20) << " MiB) in " << recSec * 1e3
+         << " ms, " << rep.records / recSec / 1e6 << " M records/s\n";
+    filesystem::remove(path);
+}
+
+void benchBacktest() {
+    const int ITEMS = 2000, ORDERS_PER_DAY = 50000, DAYS = benchSize > 0 ? (int)benchSize : 365;
+    mt19937 rng(7);
+    CatalogColumns opening;
+    opening.reserve(ITEMS);
+    double zipfSum = 0;
+    for (int i = 0; i < ITEMS; ++i) zipfSum += 1.0 / pow(i + 1, 0.9);
+    Item proto(0, "", 0.0, 0);
+    for (int i = 0; i < ITEMS; ++i) {
+        double dailyUnits = 2.0 * ORDERS_PER_DAY * (1.0 / pow(i + 1, 0.9)) / zipfSum;
+        proto.id = i; proto.basePrice = 20 + rng() % 48000 / 100.0;
+        proto.stock = max(5, (int)(dailyUnits * (0.8 + 0.6 * (rng() % 1000) / 1000.0)));
+        proto.perishable = rng() % 2; proto.expiryDays = proto.perishable ? 5 : 365;
+        opening.append(proto);
+    }
+    auto t0 = chrono::steady_clock::now();
+    vector<ReplayOrder> orders = synthesizeOrderStream(ITEMS, DAYS, ORDERS_PER_DAY, 8);
+    double genSec = secondsSince(t0);
+
+    vector<PricingPolicy> policies = policyGrid();
+    t0 = chrono::steady_clock::now();
+    vector<BacktestResult> results = runBacktests(opening, orders, policies);
+    double wallSec = secondsSince(t0);
+    double cpuSec = 0;
+    for (auto &r : results) cpuSec += r.seconds;
+
+    cout << "Backtest, " << ITEMS << " SKUs, " << DAYS << " days, " << orders.size() << " orders ("
+         << orders.size() * sizeof(ReplayOrder) / (1 << 20) << " MiB shared), " << policies.size() << " policies on "
+         << min<size_t>(max(1u, thread::hardware_concurrency()), policies.size()) << " thread(s)\n"
+         << "  stream generated in " << genSec << " s; replay " << wallSec << " s wall, "
+         << cpuSec / policies.size() << " s per policy, " << orders.size() * policies.size() / wallSec / 1e6
+         << " M order-replays/s\n";
+    printBacktestResults(results, 5);
+    for (auto &r : results)
+        if (r.policy.alpha == 0.02 && r.policy.beta == 0.001 && r.policy.gamma == 0.05 && r.policy.delta == 0.05) {
+            cout << "  live policy:\n";
+            printBacktestResults({r}, 1);
+        }
+}
+
+// Zipfian item popularity: a few hot SKUs get most of the orders
+vector<int> zipfSlots(int items, int count, double skew, mt19937 &rng) {
+    vector<double> cdf(items);
+    double sum = 0;
+    for (int i = 0; i < items; ++i) { sum += 1.0 / pow(i + 1, skew); cdf[i] = sum; }
+    uniform_real_distribution<double> u(0.0, sum);
+    vector<int> out(count);
+    for (int &slot : out) slot = lower_bound(cdf.begin(), cdf.end(), u(rng)) - cdf.begin();
+    return out;
+}
+
+void benchConcurrentOrders() {
+    const int ITEMS = 1000000, ORDERS = benchSize > 0 ? (int)benchSize : 4000000;
+    mt19937 rng(5);
+    CatalogColumns c;
+    c.reserve(ITEMS);
+    Item proto(0, "", 10.0, 0);
+    for (int i = 0; i < ITEMS; ++i) { proto.id = i; proto.stock = 50 + rng() % 200; c.append(proto); }
+
+    vector<int> slots = zipfSlots(ITEMS, ORDERS, 0.99, rng);
+    vector<OrderBatch> batches((ORDERS + OrderBatch::CAPACITY - 1) / OrderBatch::CAPACITY);
+    for (int i = 0; i < ORDERS; ++i) {
+        OrderBatch &b = batches[i / OrderBatch::CAPACITY];
+        b.lines[b.count++] = {i, slots[i], 1 + (int)(i % 3)};
+    }
+
+    // Single-threaded baseline: plain columns, no atomics
+    vector<int> stock(c.stock), sold(c.soldToday);
+    long long baseOk = 0;
+    auto t0 = chrono::steady_clock::now();
+    for (auto &b : batches)
+        for (int i = 0; i < b.count; ++i) {
+            const OrderLine &o = b.lines[i];
+            if (stock[o.slot] >= o.qty) { stock[o.slot] -= o.qty; sold[o.slot] += o.qty; baseOk++; }
+        }
+    double baseSec = secondsSince(t0);
+    cout << "Concurrent orders, " << ORDERS << " orders over " << ITEMS << " SKUs (Zipf 0.99), "
+         << thread::hardware_concurrency() << " hw threads\n"
+         << "  single thread, no atomics: " << ORDERS / baseSec / 1e6 << " M orders/s, fulfilled " << baseOk << "\n";
+
+    for (int workers : {1, 2, 4, 8, 16}) {
+        int producers = max(1, workers / 4);
+        auto t1 = chrono::steady_clock::now();
+        ConcurrentOrderEngine engine(c, workers);
+        vector<thread> feeders;
+        for (int p = 0; p < producers; ++p)
+            feeders.emplace_back([&, p] {
+                for (size_t b = p; b < batches.size(); b += producers) engine.submit(batches[b]);
+            });
+        for (auto &f : feeders) f.join();
+        engine.finish();
+        double sec = secondsSince(t1);
+        long long total = engine.fulfilledOrders() + engine.backorderedOrders();
+        cout << "  " << setw(2) << workers << " workers / " << producers << " producers: " << ORDERS / sec / 1e6
+             << " M orders/s, fulfilled " << engine.fulfilledOrders() << ", backordered " << engine.backorderedOrders()
+             << (total == ORDERS && (long long)engine.drainBackorders().size() == engine.backorderedOrders() ? "" : "  (LOST ORDERS)")
+             << "\n";
+    }
+}
+
+void runBenchmarks(const string &which) {
+    const vector<pair<string, function<void()>>> benches = {
+        {"heap", benchIndexedHeaps},
+        {"pricetree", benchPriceTree},
+        {"idindex", benchIdIndex},
+        {"sort", benchSorting},
+        {"reprice", benchRepricing},
+        {"incremental", benchIncrementalPricing},
+        {"orders", benchConcurrentOrders},
+        {"history", benchPriceHistory},
+        {"wal", benchOrderLog},
+        {"backtest", benchBacktest},
+    };
+    for (auto &b : benches)
+        if (which.empty() || which == b.first) b.second();
+}
+
 /* =========================
    Demo / Main Program
    ========================= */
 
-int main() {
+int main(int argc, char **argv) {
     ios::sync_with_stdio(false);
     cin.tie(nullptr);
 
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        if (argc > 3) benchSize = atoll(argv[3]);
+        runBenchmarks(argc > 2 ? argv[2] : "");
+        return 0;
+    }
+    // Orders are durable only with --log <path>: that log is replayed on start and
+    // appended to. Without it every run starts from the seeded catalog.
+    string logPath;
+    if (argc > 2 && string(argv[1]) == "--log") logPath = argv[2];
+    else if (argc > 1) {
+        cout << "Usage: " << argv[0] << " [--log <order log path>] | --bench [name] [size]\n";
+        return 1;
+    }
+
     cout << "=== Shop & Restaurant Dynamic Pricing System (Option B Demonstration) ===\n\n";
 
     // Initialize catalog
@@ -449,24 +2793,29 @@ int main() {
     for (auto &it : seed) {
         catalog.addOrUpdate(it);
     }
+    const CatalogColumns opening = catalog.columns();   // start-of-day state for backtests
 
-    // Build BST and AVL (for demo)
-    BST bst; AVLTree avl;
-    for (auto &it : seed) {
-        bst.insert(it);
-        avl.insert(it);
-    }
 
-    // Build initial heaps
-    priority_queue<Item, vector<Item>, DemandComparator> demandHeap;
-    priority_queue<Item, vector<Item>, PriceMinComparator> cheapHeap;
-
-    // Add initial items to heaps
-    auto all = catalog.allItems();
-    for (auto &it : all) {
-        demandHeap.push(it);
-        cheapHeap.push(it);
+    // Build initial heaps and the price tree (one entry per catalog slot)
+    DemandHeap demandHeap(catalog.size());
+    PriceHeap cheapHeap(catalog.size());
+    PriceTree priceTree;
+    for (int slot = 0; slot < catalog.size(); ++slot) {
+        const CatalogColumns &c = catalog.columns();
+        demandHeap.set(slot, c.soldToday[slot]);
+        cheapHeap.set(slot, c.currentPrice[slot]);
+        priceTree.insert(c.currentPrice[slot], c.id[slot], slot);
     }
+    vector<int> topSlots;
+
+    // Incremental pricing: the cheap-items heap and the price tree follow the change stream
+    PricingEngine pricing(catalog.columns());
+    pricing.subscribe([&](const vector<PriceChange> &changes) {
+        for (auto &ch : changes) {
+            cheapHeap.set(ch.slot, ch.newPrice);
+            priceTree.update(ch.oldPrice, ch.newPrice, catalog.columns().id[ch.slot], ch.slot);
+        }
+    });
 
     // Graph of suppliers (0 = our store, 1..n suppliers)
     Graph suppliers;
@@ -478,11 +2827,28 @@ int main() {
     };
     addEdge(0,1,15); addEdge(1,2,20); addEdge(0,3,12); addEdge(3,4,25); addEdge(2,5,30);
 
-    // Order manager
+    // Order manager, durable through the order log if one was given: replay what survived
+    // the last run
     OrderManager om;
+    OrderLogReplay recovered;
+    unique_ptr<OrderLog> orderLog;
+    if (!logPath.empty()) {
+        recovered = om.recover(logPath, catalog, pricing);
+        orderLog.reset(new OrderLog(logPath));
+        if (orderLog->isOpen()) om.attachLog(orderLog.get());
+        else cout << "Warning: " << logPath << " not writable, orders are not durable.\n";
+    }
+    if (recovered.records > 0) {
+        for (int slot = 0; slot < catalog.size(); ++slot) demandHeap.set(slot, catalog.columns().soldToday[slot]);
+        cout << "Recovered " << recovered.records << " order log records";
+        if (recovered.discardedBytes > 0) cout << " (dropped " << recovered.discardedBytes << " bytes of torn tail)";
+        cout << ".\n";
+    }
 
     // Simulated clock hour
     int hour = 12;
+    int day = 0;
+    PriceHistoryStore history("price_history");
 
     // Main simulation loop with menu
     bool running = true;
@@ -496,18 +2862,20 @@ int main() {
              << "5. Show Top Demand Items\n"
              << "6. Replenish (find nearest supplier with Dijkstra)\n"
              << "7. Run Sorting Demo (Quick/Merge/Heap)\n"
-             << "8. Print BST / AVL in-order\n"
+             << "8. Items by price (range / k-th / rank)\n"
              << "9. Show cheap items (min-heap peek)\n"
              << "10. Show failed orders\n"
              << "11. Advance hour\n"
+             << "12. Bulk order rush (concurrent engine)\n"
+             << "13. Price history for an item\n"
+             << "14. Backtest pricing policies\n"
              << "0. Exit\nChoice: ";
         cin >> menuChoice;
 
         switch (menuChoice) {
             case 1: {
                 cout << "\n*** Catalog ***\n";
-                auto items = catalog.allItems();
-                for (auto &it : items) printItem(it);
+                for (int slot = 0; slot < catalog.size(); ++slot) printItem(catalog.row(slot));
                 break;
             }
             case 2: {
@@ -518,46 +2886,38 @@ int main() {
                 cout << "Customer name: ";
                 cin >> cust;
                 int oid = om.placeOrder(iid, qty, hour, cust);
-                cout << "Order placed. OrderID: " << oid << "\n";
+                if (oid < 0) cout << "Order log write failed; order not placed.\n";
+                else cout << "Order placed. OrderID: " << oid << "\n";
                 break;
             }
             case 3: {
                 // move incoming to processing and process
                 om.moveToProcessing();
-                om.processOrders(catalog, demandHeap);
+                om.processOrders(catalog, demandHeap, pricing);
                 break;
             }
             case 4: {
                 cout << "Recomputing dynamic prices for hour " << hour << "...\n";
-                auto items = catalog.allItems();
-                for (auto &it : items) {
-                    Item *p = catalog.getById(it.id);
-                    if (!p) continue;
-                    p->currentPrice = computeDynamicPrice(*p, hour);
-                    p->lastUpdateHour = hour;
-                }
-                cout << "Prices updated.\n";
+                PricingTickStats st = pricing.tick(hour);
+                cout << "Prices updated" << (st.bandChanged ? " (time band changed: full reprice)" : "")
+                     << ". Repriced " << st.repriced << ", skipped " << st.skipped << ", changed " << st.changed << ".\n";
                 break;
             }
             case 5: {
                 cout << "Top demand items (by soldToday) — peek 5:\n";
-                // copy heap to display top 5
-                auto tmp = demandHeap;
-                int cnt = 0;
-                while (!tmp.empty() && cnt < 5) {
-                    Item it = tmp.top(); tmp.pop();
-                    cout << it.name << " soldToday=" << it.soldToday << " currentPrice=" << it.currentPrice << "\n";
-                    cnt++;
+                demandHeap.topK(5, topSlots);
+                for (int slot : topSlots) {
+                    const CatalogColumns &c = catalog.columns();
+                    cout << c.name[slot] << " soldToday=" << c.soldToday[slot] << " currentPrice=" << c.currentPrice[slot] << "\n";
                 }
                 break;
             }
             case 6: {
                 // simulate needing to replenish item with lowest stock
-                auto items = catalog.allItems();
-                sort(items.begin(), items.end(), [](const Item &a, const Item &b){ return a.stock < b.stock; });
-                if (items.empty()) { cout << "No items.\n"; break; }
-                Item low = items[0];
-                cout << "Lowest stock item: " << low.name << " stock=" << low.stock << "\n";
+                CatalogColumns &c = catalog.columns();
+                if (c.size() == 0) { cout << "No items.\n"; break; }
+                int low = min_element(c.stock.begin(), c.stock.end()) - c.stock.begin();
+                cout << "Lowest stock item: " << c.name[low] << " stock=" << c.stock[low] << "\n";
                 // find shortest supplier route from node 0 to any supplier node (we choose 1..n)
                 auto dist = dijkstraShortest(suppliers, 0);
                 int bestNode = -1, bestTime = INT_MAX;
@@ -567,59 +2927,57 @@ int main() {
                 if (bestNode == -1) cout << "No supplier reachable.\n";
                 else cout << "Nearest supplier: Node " << bestNode << " time " << bestTime << " min.\n";
                 // simulate replenishment
-                Item *p = catalog.getById(low.id);
-                if (p) {
-                    p->stock += 50; // restock
-                    cout << "Restocked " << p->name << " by 50 units. New stock=" << p->stock << "\n";
-                }
+                if (!om.logRestock(c.id[low], 50)) cout << "Warning: restock not recorded in the order log.\n";
+                pricing.restock(low, 50);
+                cout << "Restocked " << c.name[low] << " by 50 units. New stock=" << c.stock[low] << "\n";
                 break;
             }
             case 7: {
                 cout << "Sorting demo (by dynamic price descending):\n";
-                auto items = catalog.allItems();
-                // ensure prices aktual
-                for (auto &it : items) {
-                    Item *pp = catalog.getById(it.id);
-                    if (pp) it.currentPrice = pp->currentPrice;
-                }
-                // quick sort
-                auto arrQ = items;
-                quickSort(arrQ, 0, (int)arrQ.size()-1, [](const Item &a, const Item &b){
-                    return a.currentPrice > b.currentPrice; // descending
-                });
-                cout << "QuickSort top 3:\n";
-                for (int i=0;i<min((int)arrQ.size(),3);++i) printItem(arrQ[i]);
+                // sort (price, slot) keys; items are looked up only for printing
+                vector<SortKey> keys = sortKeys(catalog.columns().currentPrice);
+                auto printTop3 = [&](const char *title, const vector<SortKey> &sorted) {
+                    cout << title << " top 3:\n";
+                    for (int i=0;i<min((int)sorted.size(),3);++i) printItem(catalog.row(sorted[i].slot));
+                };
 
-                // merge sort
-                auto arrM = items;
-                if (!arrM.empty()) mergeSort(arrM, 0, (int)arrM.size()-1, [](const Item &a, const Item &b){
-                    return a.currentPrice > b.currentPrice;
-                });
-                cout << "MergeSort top 3:\n";
-                for (int i=0;i<min((int)arrM.size(),3);++i) printItem(arrM[i]);
-
-                // heap sort
-                auto arrH = items;
-                heapSort(arrH, [](const Item &a, const Item &b){ return a.currentPrice > b.currentPrice; });
-                cout << "HeapSort top 3:\n";
-                for (int i=0;i<min((int)arrH.size(),3);++i) printItem(arrH[i]);
+                auto arrQ = keys;
+                quickSort(arrQ, 0, (int)arrQ.size()-1, SortKeyGreater());
+                printTop3("QuickSort", arrQ);
+
+                auto arrM = keys;
+                mergeSort(arrM, 0, (int)arrM.size()-1, SortKeyGreater());
+                printTop3("MergeSort", arrM);
+
+                auto arrH = keys;
+                heapSort(arrH, SortKeyGreater());
+                printTop3("HeapSort", arrH);
                 break;
             }
             case 8: {
-                cout << "BST in-order (by id):\n";
-                auto bitems = bst.inOrder();
-                for (auto &it : bitems) printItem(it);
-                cout << "\nAVL in-order (by id):\n";
-                auto aitems = avl.inOrder();
-                for (auto &it : aitems) printItem(it);
+                cout << "Items by current price:\n";
+                priceTree.forEachInOrder([&](double, int, int slot) { printItem(catalog.row(slot)); });
+                double lo, hi;
+                cout << "Price range [lo hi]: ";
+                cin >> lo >> hi;
+                vector<int> inRange;
+                priceTree.collectRange(lo, hi, inRange);
+                cout << priceTree.countInRange(lo, hi) << " item(s) in range:\n";
+                for (int slot : inRange) printItem(catalog.row(slot));
+                int median = priceTree.kth(priceTree.size() / 2);
+                if (median >= 0) {
+                    const CatalogColumns &c = catalog.columns();
+                    cout << "Median-priced item: " << c.name[median] << " (" << c.currentPrice[median] << "), "
+                         << priceTree.rank(c.currentPrice[median], c.id[median]) << " item(s) cheaper\n";
+                }
                 break;
             }
             case 9: {
                 cout << "6 cheapest items (min-heap peek):\n";
-                auto tmp = cheapHeap;
-                for (int i=0;i<6 && !tmp.empty(); ++i) {
-                    Item it = tmp.top(); tmp.pop();
-                    cout << it.name << " price=" << it.currentPrice << " stock=" << it.stock << "\n";
+                cheapHeap.topK(6, topSlots);
+                for (int slot : topSlots) {
+                    const CatalogColumns &c = catalog.columns();
+                    cout << c.name[slot] << " price=" << c.currentPrice[slot] << " stock=" << c.stock[slot] << "\n";
                 }
                 break;
             }
@@ -628,10 +2986,69 @@ int main() {
                 break;
             }
             case 11: {
+                history.recordHour(catalog.columns(), day * 24 + hour);   // prices in effect this hour
                 hour = (hour + 1) % 24;
+                if (hour == 0) day++;
                 cout << "Advanced hour. Current hour = " << hour << "\n";
                 break;
             }
+            case 12: {
+                int orders, workers;
+                cout << "Number of random orders and worker threads: ";
+                cin >> orders >> workers;
+                if (catalog.size() == 0) { cout << "Catalog is empty.\n"; break; }
+                ConcurrentOrderEngine engine(catalog.columns(), workers);
+                mt19937 rng(hour);
+                OrderBatch batch;
+                for (int i = 0; i < orders; ++i) {
+                    batch.lines[batch.count++] = {i + 1, (int)(rng() % catalog.size()), 1 + (int)(rng() % 3)};
+                    if (batch.count == OrderBatch::CAPACITY) { engine.submit(batch); batch.count = 0; }
+                }
+                if (batch.count > 0) engine.submit(batch);
+                engine.finish();
+                vector<int> soldBefore = catalog.columns().soldToday;
+                engine.commit(catalog.columns(), &pricing);
+                vector<pair<int, int>> sales;
+                for (int slot = 0; slot < catalog.size(); ++slot)
+                    if (int q = catalog.columns().soldToday[slot] - soldBefore[slot]) sales.push_back({catalog.columns().id[slot], q});
+                if (!om.logBulkSales(sales, hour)) cout << "Warning: bulk sales not recorded in the order log.\n";
+                for (int slot = 0; slot < catalog.size(); ++slot) demandHeap.set(slot, catalog.columns().soldToday[slot]);
+                if (!om.addBackorders(engine.drainBackorders(), catalog.columns(), hour))
+                    cout << "Warning: backorders not recorded in the order log.\n";
+                cout << "Fulfilled " << engine.fulfilledOrders() << " orders (" << engine.units() << " units), backordered "
+                     << engine.backorderedOrders() << " (option 10 lists them). Run option 4 to reprice.\n";
+                break;
+            }
+            case 13: {
+                int iid, days;
+                cout << "Enter Item ID and number of days: ";
+                cin >> iid >> days;
+                int slot = catalog.slotOf(iid);
+                if (slot < 0) { cout << "Item not found.\n"; break; }
+                int now = day * 24 + hour;
+                PriceStats st;
+                history.scan(slot, now - days * 24, now, [&](int h, double p) {
+                    cout << "  day " << h / 24 << " " << setw(2) << h % 24 << ":00  " << p << "\n";
+                    st.add(p);
+                });
+                if (st.count == 0) cout << "No history yet (recorded as hours advance).\n";
+                else cout << st.count << " hourly samples, min " << st.minPrice << ", max " << st.maxPrice
+                          << ", mean " << st.mean() << "\n";
+                break;
+            }
+            case 14: {
+                int days;
+                cout << "Days of synthetic orders to replay (0 = replay the order log): ";
+                cin >> days;
+                if (days <= 0 && logPath.empty()) { cout << "No order log (start with --log <path>).\n"; break; }
+                vector<ReplayOrder> orders = days > 0 ? synthesizeOrderStream(catalog.size(), days, 200, 1)
+                                                      : loadOrderStream(logPath, catalog);
+                if (orders.empty()) { cout << "No orders to replay.\n"; break; }
+                vector<BacktestResult> results = runBacktests(opening, orders, policyGrid());
+                cout << "Replayed " << orders.size() << " orders under " << results.size() << " policies, best by revenue:\n";
+                printBacktestResults(results, 5);
+                break;
+            }
             case 0: {
                 running = false;
                 break;
@@ -33,39 +33,315 @@ struct Zone {
 vector<Zone> zones;
 
 /***************************************************************
-                UNION-FIND (DISJOINT SET)
+          UNION-FIND (DISJOINT SET) WITH ROLLBACK
 ****************************************************************/
 
-vector<int> parentUF, rankUF;
+// Union by size without path compression: find() is an iterative O(log n) walk, and every
+// union is one recorded parent change, so checkpoint()/rollback() can undo merges in LIFO
+// order. Each root carries its component's zone count and water/energy totals.
+class RollbackDSU {
+    vector<int> parent, compSize;
+    vector<long long> water, energy;
+    vector<int> history;   // child root of each union, in order
+    int components = 0;
+public:
+    void init(int n) {
+        parent.resize(n);
+        iota(parent.begin(), parent.end(), 0);
+        compSize.assign(n, 1);
+        water.assign(n, 0);
+        energy.assign(n, 0);
+        history.clear();
+        components = n;
+    }
+    void setTotals(int zone, long long w, long long e) {   // before any union
+        water[zone] = w;
+        energy[zone] = e;
+    }
+    // A zone's own usage changed: every node on its path to the root holds a subtree
+    // total that includes it, so all of them move and rollback() still subtracts the
+    // right amounts
+    void adjustTotals(int zone, long long dWater, long long dEnergy) {
+        for (int x = zone;; x = parent[x]) {
+            water[x] += dWater;
+            energy[x] += dEnergy;
+            if (parent[x] == x) break;
+        }
+    }
 
-void initUF(int n) {
-    parentUF.resize(n);
-    rankUF.resize(n);
-    for (int i = 0; i < n; i++) {
-        parentUF[i] = i;
-        rankUF[i] = 0;
+    int find(int x) const {
+        while (parent[x] != x) x = parent[x];
+        return x;
+    }
+    bool connected(int a, int b) const { return find(a) == find(b); }
+
+    bool unite(int a, int b) {
+        a = find(a);
+        b = find(b);
+        if (a == b) return false;
+        if (compSize[a] < compSize[b]) swap(a, b);
+        parent[b] = a;
+        compSize[a] += compSize[b];
+        water[a] += water[b];
+        energy[a] += energy[b];
+        history.push_back(b);
+        components--;
+        return true;
+    }
+
+    int checkpoint() const { return history.size(); }
+    void rollback(int mark) {
+        while ((int)history.size() > mark) {
+            int b = history.back(), a = parent[b];
+            history.pop_back();
+            compSize[a] -= compSize[b];
+            water[a] -= water[b];
+            energy[a] -= energy[b];
+            parent[b] = b;
+            components++;
+        }
     }
+
+    int size() const { return parent.size(); }
+    int componentCount() const { return components; }
+    int componentSize(int x) const { return compSize[find(x)]; }
+    long long componentWater(int x) const { return water[find(x)]; }
+    long long componentEnergy(int x) const { return energy[find(x)]; }
+};
+
+RollbackDSU zoneUnion;
+
+void initUF(int n) {
+    zoneUnion.init(n);
+    for (int i = 0; i < n && i < (int)zones.size(); i++) zoneUnion.setTotals(i, zones[i].water, zones[i].energy);
 }
 
 int findUF(int x) {
-    if (parentUF[x] != x)
-        parentUF[x] = findUF(parentUF[x]);
-    return parentUF[x];
+    return zoneUnion.find(x);
 }
 
 void unionUF(int a, int b) {
-    a = findUF(a);
-    b = findUF(b);
-    if (a != b) {
-        if (rankUF[a] < rankUF[b])
-            parentUF[a] = b;
-        else if (rankUF[a] > rankUF[b])
-            parentUF[b] = a;
-        else {
-            parentUF[b] = a;
-            rankUF[a]++;
+    zoneUnion.unite(a, b);
+}
+
+/***************************************************************
+          WHAT-IF ZONE MERGES (OFFLINE DYNAMIC CONNECTIVITY)
+****************************************************************/
+
+// A merge timeline: "merge a b" links two zones, "split a b" removes the most recent
+// still-active merge of that pair, "query a b" asks about the state at that point.
+// Every link is alive over an interval of query positions; intervals are hung on a
+// segment tree over those positions and one DFS applies them with unite()/rollback(),
+// so each link is applied O(log Q) times in total instead of rebuilding per query.
+enum class MergeOp { Merge, Split, Query };
+
+struct ZoneMergeEvent {
+    MergeOp op;
+    int a, b;
+};
+
+struct WhatIfAnswer {
+    bool connected;
+    int zones;                    // size of a's component
+    long long water, energy;      // totals of a's component
+};
+
+// Reads "operation,zone_a,zone_b" rows (datasets/case23_zone_merges.csv); unknown
+// operations and malformed rows are skipped. Returns false if the file cannot be read.
+bool loadZoneMerges(const string &path, vector<ZoneMergeEvent> &events) {
+    ifstream in(path);
+    if (!in) return false;
+    string line;
+    getline(in, line);   // header
+    while (getline(in, line)) {
+        stringstream ss(line);
+        string op, a, b;
+        if (!getline(ss, op, ',') || !getline(ss, a, ',') || !getline(ss, b, ',')) continue;
+        MergeOp kind;
+        if (op == "merge") kind = MergeOp::Merge;
+        else if (op == "split") kind = MergeOp::Split;
+        else if (op == "query") kind = MergeOp::Query;
+        else continue;
+        try { events.push_back({kind, stoi(a), stoi(b)}); } catch (...) {}
+    }
+    return true;
+}
+
+class OfflineConnectivity {
+    vector<vector<pair<int, int>>> links;   // per segment-tree node over query positions
+    int queries = 0;
+
+    void addLink(int node, int l, int r, int from, int to, pair<int, int> e) {
+        if (to <= l || r <= from) return;
+        if (from <= l && r <= to) { links[node].push_back(e); return; }
+        int mid = (l + r) / 2;
+        addLink(2 * node, l, mid, from, to, e);
+        addLink(2 * node + 1, mid, r, from, to, e);
+    }
+    void solve(int node, int l, int r, RollbackDSU &dsu, const vector<pair<int, int>> &asked, vector<WhatIfAnswer> &out) {
+        int mark = dsu.checkpoint();
+        for (auto &e : links[node]) dsu.unite(e.first, e.second);
+        if (r - l == 1) {
+            int a = asked[l].first, b = asked[l].second;
+            out[l] = {dsu.connected(a, b), dsu.componentSize(a), dsu.componentWater(a), dsu.componentEnergy(a)};
+        } else {
+            int mid = (l + r) / 2;
+            solve(2 * node, l, mid, dsu, asked, out);
+            solve(2 * node + 1, mid, r, dsu, asked, out);
         }
+        dsu.rollback(mark);
+    }
+
+public:
+    // One answer per query event, evaluated on top of dsu's current unions (which are left
+    // as they were). Events naming zones outside the DSU are ignored.
+    vector<WhatIfAnswer> run(RollbackDSU &dsu, const vector<ZoneMergeEvent> &events) {
+        vector<pair<int, int>> asked;
+        map<pair<int, int>, vector<int>> open;   // pair -> query positions where its active merges began
+        vector<tuple<int, int, pair<int, int>>> spans;
+        int n = dsu.size();
+        for (auto &ev : events) {
+            if (ev.a < 0 || ev.b < 0 || ev.a >= n || ev.b >= n) continue;
+            pair<int, int> key = minmax(ev.a, ev.b);
+            if (ev.op == MergeOp::Merge) open[key].push_back(asked.size());
+            else if (ev.op == MergeOp::Split) {
+                auto it = open.find(key);
+                if (it == open.end() || it->second.empty()) continue;
+                spans.emplace_back(it->second.back(), (int)asked.size(), key);
+                it->second.pop_back();
+            } else asked.push_back({ev.a, ev.b});
+        }
+        queries = asked.size();
+        for (auto &kv : open)
+            for (int from : kv.second) spans.emplace_back(from, queries, kv.first);
+
+        vector<WhatIfAnswer> out(queries);
+        if (queries == 0) return out;
+        links.assign(4 * queries, {});
+        for (auto &[from, to, e] : spans) addLink(1, 0, queries, from, to, e);
+        solve(1, 0, queries, dsu, asked, out);
+        return out;
+    }
+};
+
+// Independent what-if batches: each batch's merges are tried on top of the current
+// unions, its queries answered, and the merges rolled back before the next batch.
+struct WhatIfBatch {
+    vector<pair<int, int>> merges, queries;
+};
+
+vector<WhatIfAnswer> evaluateWhatIfBatches(RollbackDSU &dsu, const vector<WhatIfBatch> &batches) {
+    vector<WhatIfAnswer> out;
+    for (auto &batch : batches) {
+        int mark = dsu.checkpoint();
+        for (auto &m : batch.merges) dsu.unite(m.first, m.second);
+        for (auto &q : batch.queries)
+            out.push_back({dsu.connected(q.first, q.second), dsu.componentSize(q.first),
+                           dsu.componentWater(q.first), dsu.componentEnergy(q.first)});
+        dsu.rollback(mark);
     }
+    return out;
+}
+
+/***************************************************************
+          CONCURRENT UNION-FIND (LOCK-FREE)
+****************************************************************/
+
+// Lock-free union-find after Anderson & Woll / Jayanti & Tarjan. A union is a single CAS
+// that links one root under the other; find() does path halving with CAS, which is
+// harmless if it loses a race since it only ever points a node at an ancestor. Roots are
+// ordered by a hashed priority instead of rank, so no second word has to change
+// atomically with the link and trees stay O(log n) deep in expectation.
+class ConcurrentDSU {
+    unique_ptr<atomic<int>[]> parent;
+    int n = 0;
+
+    static uint32_t priority(uint32_t x) {   // fixed random order of the zones
+        x ^= x >> 16; x *= 0x7feb352dU;
+        x ^= x >> 15; x *= 0x846ca68bU;
+        return x ^ (x >> 16);
+    }
+    static bool below(int a, int b) {        // does root a link under root b?
+        uint32_t pa = priority(a), pb = priority(b);
+        return pa < pb || (pa == pb && a < b);
+    }
+public:
+    explicit ConcurrentDSU(int n = 0) { init(n); }
+    void init(int count) {
+        n = count;
+        parent.reset(new atomic<int>[n]);
+        for (int i = 0; i < n; i++) parent[i].store(i, memory_order_relaxed);
+    }
+    int size() const { return n; }
+
+    int find(int x) {
+        while (true) {
+            int p = parent[x].load(memory_order_acquire);
+            if (p == x) return x;
+            int gp = parent[p].load(memory_order_acquire);
+            if (p != gp) parent[x].compare_exchange_weak(p, gp, memory_order_release, memory_order_relaxed);
+            x = gp;
+        }
+    }
+
+    bool unite(int a, int b) {
+        while (true) {
+            a = find(a);
+            b = find(b);
+            if (a == b) return false;
+            if (!below(a, b)) swap(a, b);
+            int expected = a;
+            if (parent[a].compare_exchange_strong(expected, b, memory_order_acq_rel, memory_order_relaxed)) return true;
+        }
+    }
+
+    // Linearizable even while other threads unite: if a is no longer a root after both
+    // finds, something moved and we look again.
+    bool connected(int a, int b) {
+        while (true) {
+            a = find(a);
+            b = find(b);
+            if (a == b) return true;
+            if (parent[a].load(memory_order_acquire) == a) return false;
+        }
+    }
+};
+
+// Unions a batch of zone pairs with one contiguous chunk per thread. Returns how many
+// unions actually joined two components.
+long long parallelUnite(ConcurrentDSU &dsu, const vector<pair<int, int>> &edges, int threads = 0) {
+    if (threads <= 0) threads = max(1u, thread::hardware_concurrency());
+    size_t m = edges.size();
+    threads = max<size_t>(1, min<size_t>(threads, m / 4096 + 1));
+    vector<long long> joined(threads, 0);
+    auto work = [&](int t) {
+        size_t begin = m * t / threads, end = m * (t + 1) / threads;
+        long long local = 0;
+        for (size_t i = begin; i < end; i++) local += dsu.unite(edges[i].first, edges[i].second);
+        joined[t] = local;
+    };
+    if (threads == 1) work(0);
+    else {
+        vector<thread> pool;
+        for (int t = 0; t < threads; t++) pool.emplace_back(work, t);
+        for (auto &th : pool) th.join();
+    }
+    return accumulate(joined.begin(), joined.end(), 0LL);
+}
+
+// Collapses a large edge list in parallel, then folds the result into zoneUnion with at
+// most one union per zone, so the rollback DSU keeps its totals and history.
+long long bulkConnectZones(const vector<pair<int, int>> &edges, int threads = 0) {
+    int n = zoneUnion.size();
+    vector<pair<int, int>> valid;
+    valid.reserve(edges.size());
+    for (auto &e : edges)
+        if (e.first >= 0 && e.second >= 0 && e.first < n && e.second < n) valid.push_back(e);
+    ConcurrentDSU dsu(n);
+    parallelUnite(dsu, valid, threads);
+    long long joined = 0;
+    for (int i = 0; i < n; i++) joined += zoneUnion.unite(i, dsu.find(i));
+    return joined;
 }
 
 /***************************************************************
@@ -114,87 +390,669 @@ int queryST(int idx, int l, int r, int ql, int qr) {
 }
 
 /***************************************************************
-                     AVL TREE FOR POLLUTION DATA
+          MULTI-METRIC SEGMENT TREE (ITERATIVE, LAZY)
 ****************************************************************/
 
-struct AVL {
-    int key;
-    int height;
-    AVL *left, *right;
+// Bottom-up segment tree over M metrics. Aggregates live in flat columns indexed
+// node * M + metric, so one walk serves every metric from the same cache lines: leaves
+// keep just their value (T), inner nodes a double sum plus T min and max. Nodes p >= n
+// are the leaves and a range is walked from both ends without recursion. Range updates
+// are lazy affine maps x -> mul * x + add, which covers add (mul = 1), assign (mul = 0)
+// and scaling; nodes whose children are both leaves apply a map to them at once, so only
+// the upper half of the inner nodes carries tags. Pending maps are tracked per metric and
+// an update only pushes and rebuilds its own metric. Works for any n, not just powers of
+// two; ranges are inclusive like queryST.
+
+enum Metric { WATER, ENERGY, WASTE, POLLUTION, METRIC_COUNT };
+const char* metricNames[METRIC_COUNT] = {"water", "energy", "waste", "pollution"};
+
+template<class T, int M>
+class MetricSegmentTree {
+    static_assert(M <= 8, "pending metrics are a byte mask");
+public:
+    struct Stats {
+        double sum[M];
+        T minv[M], maxv[M];
+    };
+
+    MetricSegmentTree() {}
+    explicit MetricSegmentTree(int size) { resize(size); }
+
+    void resize(int size) {
+        n = size;
+        h = n > 0 ? 32 - __builtin_clz(n) : 0;
+        tagged = (n + 1) / 2;    // p < tagged  <=>  2p < n: at least one child is inner
+        leaf.assign((size_t)n * M, T(0));
+        sum.assign((size_t)n * M, 0.0);
+        lo.assign((size_t)n * M, T(0));
+        hi.assign((size_t)n * M, T(0));
+        mul.assign((size_t)tagged * M, T(1));
+        add.assign((size_t)tagged * M, T(0));
+        pending.assign(tagged, 0);
+    }
+
+    // Fills every leaf from value(i, metric) and builds the inner nodes bottom-up
+    template<class Get>
+    void build(Get value) {
+        for (int i = 0; i < n; i++)
+            for (int m = 0; m < M; m++) leaf[(size_t)i * M + m] = (T)value(i, m);
+        fill(mul.begin(), mul.end(), T(1));
+        fill(add.begin(), add.end(), T(0));
+        fill(pending.begin(), pending.end(), 0);
+        if (n > 0) rebuild(0, n, ALL);
+    }
+
+    // metric := mulBy * metric + addTo for zones l..r
+    void update(int l, int r, int metric, T mulBy, T addTo) {
+        l = max(l, 0);
+        r = min(r, n - 1);
+        if (l > r) return;
+        if (l == r) {
+            setPoint(l, metric, mulBy, addTo);
+            return;
+        }
+        r++;
+        const uint8_t mask = 1 << metric;
+        push(l, mask);
+        push(r - 1, mask);
+        int l0 = l, r0 = r, k = 1;
+        for (l += n, r += n; l < r; l >>= 1, r >>= 1, k <<= 1) {
+            if (l & 1) apply(l++, metric, mulBy, addTo, k);
+            if (r & 1) apply(--r, metric, mulBy, addTo, k);
+        }
+        rebuild(l0, l0 + 1, mask);
+        if (r0 - 1 != l0) rebuild(r0 - 1, r0, mask);
+    }
+    void addRange(int l, int r, int metric, T delta) { update(l, r, metric, T(1), delta); }
+    void assignRange(int l, int r, int metric, T value) { update(l, r, metric, T(0), value); }
+    void scaleRange(int l, int r, int metric, T factor) { update(l, r, metric, factor, T(0)); }
+
+    // Sum, min and max of every metric over zones l..r in one walk
+    Stats query(int l, int r) {
+        Stats s;
+        for (int m = 0; m < M; m++) {
+            s.sum[m] = 0;
+            s.minv[m] = numeric_limits<T>::max();
+            s.maxv[m] = numeric_limits<T>::lowest();
+        }
+        l = max(l, 0);
+        r = min(r, n - 1);
+        if (l > r) return s;
+        r++;
+        push(l, ALL);
+        if (r - 1 != l) push(r - 1, ALL);
+        for (l += n, r += n; l < r; l >>= 1, r >>= 1) {
+            if (l & 1) take(s, l++);
+            if (r & 1) take(s, --r);
+        }
+        return s;
+    }
+    T value(int i, int metric) {
+        push(i, 1 << metric);
+        return leaf[(size_t)i * M + metric];
+    }
+
+    int size() const { return n; }
+    size_t memoryBytes() const {
+        return (leaf.capacity() + lo.capacity() + hi.capacity() + mul.capacity() + add.capacity()) * sizeof(T)
+             + sum.capacity() * sizeof(double) + pending.capacity();
+    }
+
+private:
+    static constexpr uint8_t ALL = (1 << M) - 1;
+
+    int n = 0, h = 0, tagged = 0;
+    vector<T> leaf;             // leaf i, metric m at i * M + m
+    vector<double> sum;         // inner node p at p * M + m (p = 0 unused)
+    vector<T> lo, hi;
+    vector<T> mul, add;         // pending map of inner node p < tagged; identity = (1, 0)
+    vector<uint8_t> pending;    // bit m: node p has a non-identity map for metric m
+
+    double sumOf(int p, int m) const { return p >= n ? (double)leaf[(size_t)(p - n) * M + m] : sum[(size_t)p * M + m]; }
+    T loOf(int p, int m) const { return p >= n ? leaf[(size_t)(p - n) * M + m] : lo[(size_t)p * M + m]; }
+    T hiOf(int p, int m) const { return p >= n ? leaf[(size_t)(p - n) * M + m] : hi[(size_t)p * M + m]; }
+
+    void take(Stats &s, int p) const {
+        if (p >= n) {
+            const T *v = &leaf[(size_t)(p - n) * M];
+            for (int m = 0; m < M; m++) {
+                s.sum[m] += v[m];
+                s.minv[m] = min(s.minv[m], v[m]);
+                s.maxv[m] = max(s.maxv[m], v[m]);
+            }
+            return;
+        }
+        const double *ps = &sum[(size_t)p * M];
+        const T *pl = &lo[(size_t)p * M], *ph = &hi[(size_t)p * M];
+        for (int m = 0; m < M; m++) {
+            s.sum[m] += ps[m];
+            s.minv[m] = min(s.minv[m], pl[m]);
+            s.maxv[m] = max(s.maxv[m], ph[m]);
+        }
+    }
+    // Map inner node p's aggregates (k leaves)
+    void mapInner(int p, int m, T a, T b, int k) {
+        size_t x = (size_t)p * M + m;
+        sum[x] = a * sum[x] + (double)b * k;
+        T l = a * lo[x] + b, r = a * hi[x] + b;
+        lo[x] = min(l, r);
+        hi[x] = max(l, r);
+    }
+    // Map node p (k leaves); an inner node either composes the map into its tag or,
+    // when both children are leaves, hands it straight to them
+    void apply(int p, int m, T a, T b, int k) {
+        if (p >= n) {
+            T &v = leaf[(size_t)(p - n) * M + m];
+            v = a * v + b;
+            return;
+        }
+        mapInner(p, m, a, b, k);
+        if (p < tagged) {
+            size_t x = (size_t)p * M + m;
+            mul[x] = a * mul[x];
+            add[x] = a * add[x] + b;
+            pending[p] |= 1 << m;
+        } else {
+            apply(2 * p, m, a, b, 1);
+            apply(2 * p + 1, m, a, b, 1);
+        }
+    }
+    // Single zone: push the metric's maps off the one path, change the leaf and
+    // recompute that metric on the way back up from the siblings
+    void setPoint(int i, int m, T a, T b) {
+        push(i, 1 << m);
+        int p = i + n;
+        T &v = leaf[(size_t)i * M + m];
+        v = a * v + b;
+        T vl = v, vh = v;
+        double vs = v;
+        while (p > 1) {    // the push above left no map on the path
+            int sib = p ^ 1;
+            p >>= 1;
+            vs += sumOf(sib, m);
+            vl = min(vl, loOf(sib, m));
+            vh = max(vh, hiOf(sib, m));
+            size_t x = (size_t)p * M + m;
+            sum[x] = vs;
+            lo[x] = vl;
+            hi[x] = vh;
+        }
+    }
+    // Recompute the metrics in mask for the ancestors of leaves [l, r) from their children
+    // plus their own tags
+    void rebuild(int l, int r, uint8_t mask) {
+        int k = 2;
+        for (l += n, r += n - 1; l > 1; k <<= 1) {
+            l >>= 1;
+            r >>= 1;
+            for (int p = r; p >= l; --p)
+                for (int m = 0; m < M; m++) {
+                    if (!(mask >> m & 1)) continue;
+                    size_t x = (size_t)p * M + m;
+                    sum[x] = sumOf(2 * p, m) + sumOf(2 * p + 1, m);
+                    lo[x] = min(loOf(2 * p, m), loOf(2 * p + 1, m));
+                    hi[x] = max(hiOf(2 * p, m), hiOf(2 * p + 1, m));
+                    if (p < tagged && (pending[p] >> m & 1)) mapInner(p, m, mul[x], add[x], k);
+                }
+        }
+    }
+    // Hand the pending maps in mask down the path to leaf i, top level first
+    void push(int i, uint8_t mask) {
+        i += n;
+        for (int s = h, k = 1 << (h - 1); s > 0; --s, k >>= 1) {
+            int p = i >> s;
+            if (p >= tagged) continue;
+            uint8_t due = pending[p] & mask;
+            if (!due) continue;
+            for (int m = 0; m < M; m++) {
+                if (!(due >> m & 1)) continue;
+                size_t x = (size_t)p * M + m;
+                apply(2 * p, m, mul[x], add[x], k);
+                apply(2 * p + 1, m, mul[x], add[x], k);
+                mul[x] = T(1);
+                add[x] = T(0);
+            }
+            pending[p] &= ~due;
+        }
+    }
 };
 
-AVL* newAVLNode(int key) {
-    AVL* node = new AVL();
-    node->key = key;
-    node->height = 1;
-    node->left = node->right = NULL;
-    return node;
+using ZoneMetricTree = MetricSegmentTree<float, METRIC_COUNT>;
+ZoneMetricTree zoneMetrics;
+
+int &zoneMetric(Zone &z, int m) {
+    switch (m) {
+        case WATER: return z.water;
+        case ENERGY: return z.energy;
+        case WASTE: return z.waste;
+        default: return z.pollution;
+    }
 }
+int zoneMetric(const Zone &z, int m) { return zoneMetric(const_cast<Zone &>(z), m); }
 
-int height(AVL* N) {
-    return (N == NULL) ? 0 : N->height;
+void buildZoneMetrics() {
+    zoneMetrics.resize(zones.size());
+    zoneMetrics.build([](int i, int m) { return (double)zoneMetric(zones[i], m); });
 }
 
-int getBalance(AVL* N) {
-    return (N == NULL) ? 0 : height(N->left) - height(N->right);
+// Copies zone i's metric back from zoneMetrics after an edit and moves the union-find
+// component totals by the same amount. Metrics are whole units, so a fractional result
+// (a % change, say) is rounded in the tree too and every copy holds the same value.
+void syncZoneMetric(int i, int m) {
+    int &field = zoneMetric(zones[i], m);
+    int now = (int)llround(zoneMetrics.value(i, m));
+    if (zoneMetrics.value(i, m) != now) zoneMetrics.assignRange(i, i, m, now);
+    if (m == WATER) zoneUnion.adjustTotals(i, now - field, 0);
+    else if (m == ENERGY) zoneUnion.adjustTotals(i, 0, now - field);
+    field = now;
 }
 
-AVL* rightRotate(AVL* y) {
-    AVL* x = y->left;
-    AVL* T = x->right;
+/***************************************************************
+          PERSISTENT SEGMENT TREE (VERSIONED ZONE HISTORY)
+****************************************************************/
 
-    x->right = y;
-    y->left = T;
+// Every point update copies only the root-to-leaf path (depth + 1 arena nodes), so all
+// earlier versions stay intact and queryable in O(log n). Versions carry a timestamp.
+// The arena is a list of fixed blocks, so it grows without moving nodes, and nodes only
+// ever point at older nodes. compactBefore() uses that: it thins the versions added
+// since the previous compaction and rewrites only the arena suffix they own.
+template <typename T>
+class PersistentSegmentTree {
+    struct Node {
+        int left, right;
+        T sum;
+    };
+public:
+    struct Version {
+        long long time;
+        int root;
+    };
+private:
+    static constexpr int BLOCK_BITS = 16;
+    vector<unique_ptr<Node[]>> blocks;   // node 0 is an all-zero subtree of any size
+    size_t used = 0;
+    vector<Version> versions;
+    int n = 0;
+    size_t frozenVersions = 0, frozenNodes = 0;   // already compacted prefix
+
+    Node &at(int x) { return blocks[x >> BLOCK_BITS][x & ((1 << BLOCK_BITS) - 1)]; }
+    const Node &at(int x) const { return blocks[x >> BLOCK_BITS][x & ((1 << BLOCK_BITS) - 1)]; }
+    int newNode(int left, int right, T sum) {
+        if (used == blocks.size() << BLOCK_BITS) blocks.emplace_back(new Node[1 << BLOCK_BITS]);
+        at(used) = {left, right, sum};
+        return (int)used++;
+    }
+    template <typename F>
+    int buildAt(int lo, int hi, F &valueOf) {
+        if (lo == hi) return newNode(0, 0, valueOf(lo));
+        int mid = (lo + hi) / 2;
+        int l = buildAt(lo, mid, valueOf), r = buildAt(mid + 1, hi, valueOf);
+        return newNode(l, r, at(l).sum + at(r).sum);
+    }
+    // Copy of x with zones [l, r] re-read from valueOf; untouched subtrees are shared
+    template <typename F>
+    int setAt(int x, int lo, int hi, int l, int r, F &valueOf) {
+        if (r < lo || hi < l) return x;
+        if (lo == hi) return newNode(0, 0, valueOf(lo));
+        int mid = (lo + hi) / 2;
+        int a = setAt(at(x).left, lo, mid, l, r, valueOf), b = setAt(at(x).right, mid + 1, hi, l, r, valueOf);
+        return newNode(a, b, at(a).sum + at(b).sum);
+    }
+    T queryAt(int x, int lo, int hi, int l, int r) const {
+        if (x == 0 || r < lo || hi < l) return T(0);
+        if (l <= lo && hi <= r) return at(x).sum;
+        int mid = (lo + hi) / 2;
+        return queryAt(at(x).left, lo, mid, l, r) + queryAt(at(x).right, mid + 1, hi, l, r);
+    }
 
-    y->height = max(height(y->left), height(y->right))+1;
-    x->height = max(height(x->left), height(x->right))+1;
+public:
+    // Version 0 holds valueOf(i) for every zone i, stamped with time
+    template <typename F>
+    void build(int size, F valueOf, long long time = 0) {
+        n = size;
+        blocks.clear();
+        used = 0;
+        versions.clear();
+        newNode(0, 0, T(0));
+        versions.push_back({time, n > 0 ? buildAt(0, n - 1, valueOf) : 0});
+        frozenVersions = 0;
+        frozenNodes = 1;
+    }
 
-    return x;
-}
+    // New version equal to the latest one with zone i set to v; returns its number
+    int set(int i, T v, long long time) {
+        int path[64], depth = 0, lo = 0, hi = n - 1;
+        bool wentLeft[64];
+        for (int x = versions.back().root; lo < hi; depth++) {
+            int mid = (lo + hi) / 2;
+            path[depth] = x;
+            wentLeft[depth] = i <= mid;
+            if (wentLeft[depth]) { x = at(x).left; hi = mid; }
+            else { x = at(x).right; lo = mid + 1; }
+        }
+        int child = newNode(0, 0, v);
+        for (int d = depth - 1; d >= 0; d--) {
+            const Node &old = at(path[d]);
+            int l = wentLeft[d] ? child : old.left, r = wentLeft[d] ? old.right : child;
+            child = newNode(l, r, at(l).sum + at(r).sum);
+        }
+        versions.push_back({time, child});
+        return (int)versions.size() - 1;
+    }
+
+    // One new version with every zone i in [l, r] (inclusive, clamped) set to valueOf(i):
+    // a range edit copies only the subtrees it touches instead of one path per zone
+    template <typename F>
+    int setRange(int l, int r, F valueOf, long long time) {
+        l = max(l, 0); r = min(r, n - 1);
+        if (l > r) return latest();
+        versions.push_back({time, setAt(versions.back().root, 0, n - 1, l, r, valueOf)});
+        return (int)versions.size() - 1;
+    }
+
+    // Sum over zones [l, r] (inclusive, clamped) as of version ver
+    T query(int ver, int l, int r) const {
+        l = max(l, 0); r = min(r, n - 1);
+        if (l > r) return T(0);
+        return queryAt(versions[ver].root, 0, n - 1, l, r);
+    }
+    T value(int ver, int i) const { return query(ver, i, i); }
+
+    // Latest version stamped at or before time, -1 if the history starts later
+    int versionAt(long long time) const {
+        auto it = upper_bound(versions.begin(), versions.end(), time,
+                              [](long long t, const Version &v) { return t < v.time; });
+        return (int)(it - versions.begin()) - 1;
+    }
+    int latest() const { return (int)versions.size() - 1; }
+    int versionCount() const { return versions.size(); }
+    const Version &version(int ver) const { return versions[ver]; }
+    size_t nodeCount() const { return used; }
+    size_t memoryBytes() const {
+        return blocks.size() * (sizeof(Node) << BLOCK_BITS) + versions.capacity() * sizeof(Version);
+    }
 
-AVL* leftRotate(AVL* x) {
-    AVL* y = x->right;
-    AVL* T = y->left;
+    // Of the versions added since the last compaction, those older than cutoff are thinned
+    // to the last one in each granularity-wide time bucket and become final; newer ones are
+    // kept. Because children are always older than parents, one backward pass marks the
+    // reachable suffix and one forward pass slides it down in place, so the cost is
+    // proportional to the history since the last call. Version numbers change. Returns
+    // the number of nodes released.
+    size_t compactBefore(long long cutoff, long long granularity) {
+        vector<Version> kept(versions.begin(), versions.begin() + frozenVersions);
+        size_t finalVersions = frozenVersions;
+        for (size_t v = frozenVersions; v < versions.size(); v++) {
+            const Version &cur = versions[v];
+            bool last = v + 1 == versions.size() || versions[v + 1].time >= cutoff ||
+                        versions[v + 1].time / granularity != cur.time / granularity;
+            if (cur.time >= cutoff || last) kept.push_back(cur);
+            if (cur.time < cutoff && last) finalVersions = kept.size();
+        }
+
+        size_t oldUsed = used;
+        int base = frozenNodes;
+        vector<int> remap(oldUsed - base, -1);   // -1 unreachable, then 0 marked, then new index
+        auto mark = [&](int x) { if (x >= base) remap[x - base] = 0; };
+        for (size_t v = frozenVersions; v < kept.size(); v++) mark(kept[v].root);
+        for (int x = (int)oldUsed - 1; x >= base; x--)
+            if (remap[x - base] >= 0) { mark(at(x).left); mark(at(x).right); }
+        auto mapped = [&](int x) { return x < base ? x : remap[x - base]; };
+        used = base;
+        for (int x = base; x < (int)oldUsed; x++) {
+            if (remap[x - base] < 0) continue;
+            Node moved = at(x);
+            moved.left = mapped(moved.left);
+            moved.right = mapped(moved.right);
+            at(used) = moved;
+            remap[x - base] = (int)used++;
+        }
+        for (size_t v = frozenVersions; v < kept.size(); v++) kept[v].root = mapped(kept[v].root);
+        blocks.resize((used + (1 << BLOCK_BITS) - 1) >> BLOCK_BITS);
 
-    y->left = x;
-    x->right = T;
+        if (finalVersions > frozenVersions) frozenNodes = kept[finalVersions - 1].root + 1;
+        frozenVersions = finalVersions;
+        versions.swap(kept);
+        return oldUsed - used;
+    }
+};
 
-    x->height = max(height(x->left), height(x->right))+1;
-    y->height = max(height(y->left), height(y->right))+1;
+// One history per metric, stamped with the city clock in hours
+array<PersistentSegmentTree<double>, METRIC_COUNT> zoneHistory;
 
-    return y;
+void buildZoneHistory(long long hour) {
+    for (int m = 0; m < METRIC_COUNT; m++)
+        zoneHistory[m].build(zones.size(), [&](int i) { return zoneMetrics.value(i, m); }, hour);
 }
 
-AVL* insertAVL(AVL* node, int key) {
-    if (node == NULL) return newAVLNode(key);
+// Snapshot zones [l, r] of metric m from the live tree after a change, as one version
+void recordZoneHistory(int l, int r, int m, long long hour) {
+    zoneHistory[m].setRange(l, r, [&](int i) { return zoneMetrics.value(i, m); }, hour);
+}
 
-    if (key < node->key)
-        node->left = insertAVL(node->left, key);
-    else
-        node->right = insertAVL(node->right, key);
+/***************************************************************
+                 POLLUTION INDEX (ORDER-STATISTIC AVL)
+****************************************************************/
 
-    node->height = max(height(node->left), height(node->right)) + 1;
+// Pollution readings are small integers repeated millions of times a day, so the tree
+// holds one pooled node per distinct value with a multiplicity; every node also carries
+// the reading count and pollution sum of its subtree. Percentiles, threshold counts and
+// top-k means are single root-to-leaf walks, and memory tracks distinct values rather
+// than readings.
+class PollutionIndex {
+    struct Node {
+        int value;
+        int left, right;
+        int height;
+        long long count;    // readings with this value
+        long long size;     // readings in the subtree
+        long long sum;      // pollution total of the subtree
+    };
+    static constexpr int NIL = 0;   // pool[0] is a sentinel with size 0, height 0
+    vector<Node> pool;
+    vector<int> freeList;
+    int root = NIL;
+
+    void pull(int x) {
+        Node &n = pool[x];
+        n.size = n.count + pool[n.left].size + pool[n.right].size;
+        n.sum = n.count * n.value + pool[n.left].sum + pool[n.right].sum;
+        n.height = 1 + max(pool[n.left].height, pool[n.right].height);
+    }
+    int rotateRight(int y) {
+        int x = pool[y].left;
+        pool[y].left = pool[x].right;
+        pool[x].right = y;
+        pull(y); pull(x);
+        return x;
+    }
+    int rotateLeft(int x) {
+        int y = pool[x].right;
+        pool[x].right = pool[y].left;
+        pool[y].left = x;
+        pull(x); pull(y);
+        return y;
+    }
+    int rebalance(int x) {
+        pull(x);
+        int l = pool[x].left, r = pool[x].right;
+        int balance = pool[l].height - pool[r].height;
+        if (balance > 1) {
+            if (pool[pool[l].left].height < pool[pool[l].right].height) pool[x].left = rotateLeft(l);   // LR
+            return rotateRight(x);
+        }
+        if (balance < -1) {
+            if (pool[pool[r].right].height < pool[pool[r].left].height) pool[x].right = rotateRight(r); // RL
+            return rotateLeft(x);
+        }
+        return x;
+    }
+    int allocNode(int value, long long count) {
+        int x;
+        if (!freeList.empty()) { x = freeList.back(); freeList.pop_back(); }
+        else { x = (int)pool.size(); pool.emplace_back(); }
+        pool[x] = {value, NIL, NIL, 1, count, count, count * value};
+        return x;
+    }
+    int insertAt(int x, int value, long long count) {
+        if (x == NIL) return allocNode(value, count);
+        if (value < pool[x].value) {
+            int child = insertAt(pool[x].left, value, count);
+            pool[x].left = child;
+        } else {
+            int child = insertAt(pool[x].right, value, count);
+            pool[x].right = child;
+        }
+        return rebalance(x);
+    }
+    int detachMin(int x, int &minNode) {
+        if (pool[x].left == NIL) { minNode = x; return pool[x].right; }
+        pool[x].left = detachMin(pool[x].left, minNode);
+        return rebalance(x);
+    }
+    int removeAt(int x, int value) {
+        if (value < pool[x].value) pool[x].left = removeAt(pool[x].left, value);
+        else if (value > pool[x].value) pool[x].right = removeAt(pool[x].right, value);
+        else {
+            int l = pool[x].left, r = pool[x].right;
+            freeList.push_back(x);
+            if (l == NIL || r == NIL) return l != NIL ? l : r;
+            int m;
+            r = detachMin(r, m);
+            pool[m].left = l;
+            pool[m].right = r;
+            return rebalance(m);
+        }
+        return rebalance(x);
+    }
+    int findNode(int value) const {
+        int x = root;
+        while (x != NIL && pool[x].value != value) x = value < pool[x].value ? pool[x].left : pool[x].right;
+        return x;
+    }
+    // Adds delta readings of value along its search path without changing the shape.
+    // Repeats are the common case, so the walk is optimistic and undone if value is new.
+    bool adjustPath(int value, long long delta) {
+        for (int x = root; x != NIL;) {
+            Node &n = pool[x];
+            n.size += delta;
+            n.sum += delta * value;
+            if (n.value == value) { n.count += delta; return true; }
+            x = value < n.value ? n.left : n.right;
+        }
+        for (int x = root; x != NIL; x = value < pool[x].value ? pool[x].left : pool[x].right) {
+            pool[x].size -= delta;
+            pool[x].sum -= delta * value;
+        }
+        return false;
+    }
 
-    int balance = getBalance(node);
+public:
+    PollutionIndex() { clear(); }
 
-    if (balance > 1 && key < node->left->key)
-        return rightRotate(node);
+    void reserve(size_t distinct) { pool.reserve(distinct + 1); }
+    long long size() const { return pool[root].size; }
+    long long total() const { return pool[root].sum; }
+    int distinct() const { return (int)(pool.size() - 1 - freeList.size()); }
+    int height() const { return pool[root].height; }
+    size_t memoryBytes() const { return pool.capacity() * sizeof(Node) + freeList.capacity() * sizeof(int); }
 
-    if (balance < -1 && key > node->right->key)
-        return leftRotate(node);
+    void clear() {
+        pool.assign(1, Node{0, NIL, NIL, 0, 0, 0, 0});
+        freeList.clear();
+        root = NIL;
+    }
 
-    if (balance > 1 && key > node->left->key) {
-        node->left = leftRotate(node->left);
-        return rightRotate(node);
+    void insert(int value, long long count = 1) {
+        if (count <= 0) return;
+        if (!adjustPath(value, count)) root = insertAt(root, value, count);
+    }
+    // Removes up to count readings of value; returns how many were removed
+    long long erase(int value, long long count = 1) {
+        int x = findNode(value);
+        if (x == NIL || count <= 0) return 0;
+        if (count < pool[x].count) { adjustPath(value, -count); return count; }
+        long long had = pool[x].count;
+        root = removeAt(root, value);
+        return had;
     }
 
-    if (balance < -1 && key < node->right->key) {
-        node->right = rightRotate(node->right);
-        return leftRotate(node);
+    // Value of the k-th smallest reading (0-based); k must be < size()
+    int kth(long long k) const {
+        int x = root;
+        while (true) {
+            const Node &n = pool[x];
+            long long leftSize = pool[n.left].size;
+            if (k < leftSize) x = n.left;
+            else if (k < leftSize + n.count) return n.value;
+            else { k -= leftSize + n.count; x = n.right; }
+        }
+    }
+    // Nearest-rank percentile, p in [0, 100]; 0 when empty
+    int percentile(double p) const {
+        long long n = size();
+        if (n == 0) return 0;
+        long long k = (long long)ceil(p / 100.0 * n) - 1;
+        return kth(min(n - 1, max(0LL, k)));
     }
+    int median() const { return percentile(50); }
+
+    // Readings strictly above threshold
+    long long countAbove(int threshold) const {
+        long long c = 0;
+        for (int x = root; x != NIL;) {
+            const Node &n = pool[x];
+            if (n.value > threshold) { c += n.count + pool[n.right].size; x = n.left; }
+            else x = n.right;
+        }
+        return c;
+    }
+    // Sum of the k largest readings
+    long long topSum(long long k) const {
+        long long s = 0;
+        k = min(k, size());
+        for (int x = root; x != NIL && k > 0;) {
+            const Node &n = pool[x];
+            const Node &r = pool[n.right];
+            if (k <= r.size) { x = n.right; continue; }
+            s += r.sum;
+            k -= r.size;
+            long long take = min(k, n.count);
+            s += take * n.value;
+            k -= take;
+            x = n.left;
+        }
+        return s;
+    }
+    double topMean(long long k) const {
+        k = min(k, size());
+        return k > 0 ? (double)topSum(k) / k : 0.0;
+    }
+};
 
-    return node;
-}
+// A rolling window of hourly buckets: each hour's readings are tallied per value, and
+// when a bucket falls out of the window its tallies are erased from the index, so a
+// day's 100M readings cost one erase per distinct value per hour.
+class PollutionWindow {
+    deque<unordered_map<int, long long>> buckets;
+    int hours;
+public:
+    PollutionIndex index;
+
+    explicit PollutionWindow(int windowHours = 24) : buckets(1), hours(max(1, windowHours)) {}
+
+    void record(int value, long long count = 1) {
+        index.insert(value, count);
+        buckets.back()[value] += count;
+    }
+    void advanceHour() {
+        buckets.emplace_back();
+        while ((int)buckets.size() > hours) {
+            for (auto &[value, count] : buckets.front()) index.erase(value, count);
+            buckets.pop_front();
+        }
+    }
+    int windowHours() const { return hours; }
+};
 
 /***************************************************************
                         GRAPH + DIJKSTRA
@@ -202,7 +1060,8 @@ AVL* insertAVL(AVL* node, int key) {
 
 vector<vector<pair<int,int>>> graphCity;
 
-vector<int> dijkstra(int src, int n) {
+// Original binary-heap version, kept as the benchmark baseline
+vector<int> dijkstraBinaryHeap(int src, int n) {
     vector<int> dist(n, INT_MAX);
     priority_queue<pair<int,int>, vector<pair<int,int>>, greater<pair<int,int>>> pq;
 
@@ -224,6 +1083,219 @@ vector<int> dijkstra(int src, int n) {
     return dist;
 }
 
+/***************************************************************
+        SHORTEST-PATH ENGINE (DIAL / RADIX HEAP / 4-ARY HEAP)
+****************************************************************/
+
+// Flat adjacency (CSR): the out-edges of u are to/weight[offset[u] .. offset[u+1])
+template<class W>
+struct CSRGraph {
+    vector<int> offset, to;
+    vector<W> weight;
+    W maxWeight = 0, minWeight = 0;
+
+    int size() const { return (int)offset.size() - 1; }
+
+    static CSRGraph fromAdjacency(const vector<vector<pair<int, W>>> &adj) {
+        CSRGraph g;
+        int n = adj.size();
+        g.offset.assign(n + 1, 0);
+        for (int u = 0; u < n; u++) g.offset[u + 1] = g.offset[u] + adj[u].size();
+        g.to.resize(g.offset[n]);
+        g.weight.resize(g.offset[n]);
+        for (int u = 0; u < n; u++)
+            for (size_t i = 0; i < adj[u].size(); i++) {
+                g.to[g.offset[u] + i] = adj[u][i].first;
+                g.weight[g.offset[u] + i] = adj[u][i].second;
+            }
+        if (!g.weight.empty()) {
+            g.maxWeight = *max_element(g.weight.begin(), g.weight.end());
+            g.minWeight = *min_element(g.weight.begin(), g.weight.end());
+        }
+        return g;
+    }
+};
+
+// Dial's buckets: distances in the queue span at most C + 1 values, so a ring of C + 1
+// buckets indexed by distance mod (C + 1) needs no comparisons at all. Stale entries are
+// left behind and skipped by the caller.
+template<class W, long long C>
+class DialQueue {
+    vector<int> bucket[C + 1];
+    W current = 0;
+    size_t count = 0;
+public:
+    static const char *name() { return "dial"; }
+    static constexpr bool lazy = true;
+    void reset(int) {
+        for (auto &b : bucket) b.clear();
+        current = 0;
+        count = 0;
+    }
+    void push(int v, W d) { bucket[d % (C + 1)].push_back(v); count++; }
+    bool pop(int &v, W &d) {
+        if (count == 0) return false;
+        while (bucket[current % (C + 1)].empty()) current++;
+        vector<int> &b = bucket[current % (C + 1)];
+        v = b.back();
+        b.pop_back();
+        d = current;
+        count--;
+        return true;
+    }
+};
+
+// Radix heap: keys are monotone (never below the last pop), so a key lives in the bucket
+// of the highest bit where it differs from the last popped key. Each item moves down at
+// most 64 times over its life.
+template<class W>
+class RadixHeap {
+    static constexpr int BUCKETS = 65;
+    vector<pair<uint64_t, int>> bucket[BUCKETS];
+    uint64_t last = 0;
+    size_t count = 0;
+    static int bucketOf(uint64_t key, uint64_t last) { return key == last ? 0 : 64 - __builtin_clzll(key ^ last); }
+public:
+    static const char *name() { return "radix"; }
+    static constexpr bool lazy = true;
+    void reset(int) {
+        for (auto &b : bucket) b.clear();
+        last = 0;
+        count = 0;
+    }
+    void push(int v, W d) { bucket[bucketOf((uint64_t)d, last)].push_back({(uint64_t)d, v}); count++; }
+    bool pop(int &v, W &d) {
+        if (count == 0) return false;
+        if (bucket[0].empty()) {
+            int i = 1;
+            while (bucket[i].empty()) i++;
+            uint64_t mn = UINT64_MAX;
+            for (auto &e : bucket[i]) mn = min(mn, e.first);
+            last = mn;
+            for (auto &e : bucket[i]) bucket[bucketOf(e.first, last)].push_back(e);
+            bucket[i].clear();
+        }
+        auto e = bucket[0].back();
+        bucket[0].pop_back();
+        v = e.second;
+        d = (W)e.first;
+        count--;
+        return true;
+    }
+};
+
+// 4-ary heap with decrease-key, for weights that are not small integers
+template<class W>
+class QuaternaryHeap {
+    vector<int> heap, pos;   // pos[v] = index in heap, -1 = not queued
+    vector<W> key;
+    void up(int i) {
+        int v = heap[i];
+        while (i > 0) {
+            int p = (i - 1) / 4;
+            if (key[heap[p]] <= key[v]) break;
+            heap[i] = heap[p];
+            pos[heap[i]] = i;
+            i = p;
+        }
+        heap[i] = v;
+        pos[v] = i;
+    }
+    void down(int i) {
+        int v = heap[i], n = heap.size();
+        while (true) {
+            int c = 4 * i + 1, best = -1;
+            for (int j = c; j < min(c + 4, n); j++)
+                if (best < 0 || key[heap[j]] < key[heap[best]]) best = j;
+            if (best < 0 || key[heap[best]] >= key[v]) break;
+            heap[i] = heap[best];
+            pos[heap[i]] = i;
+            i = best;
+        }
+        heap[i] = v;
+        pos[v] = i;
+    }
+public:
+    static const char *name() { return "4-ary heap"; }
+    static constexpr bool lazy = false;
+    void reset(int n) {
+        heap.clear();
+        if ((int)pos.size() != n) { pos.assign(n, -1); key.assign(n, W()); }
+        else fill(pos.begin(), pos.end(), -1);
+    }
+    void push(int v, W d) {   // insert or decrease
+        key[v] = d;
+        if (pos[v] < 0) { heap.push_back(v); pos[v] = heap.size() - 1; }
+        up(pos[v]);
+    }
+    bool pop(int &v, W &d) {
+        if (heap.empty()) return false;
+        v = heap[0];
+        d = key[v];
+        pos[v] = -1;
+        int last = heap.back();
+        heap.pop_back();
+        if (!heap.empty()) { heap[0] = last; pos[last] = 0; down(0); }
+        return true;
+    }
+};
+
+// Queue chosen from the weight type and its compile-time bound: Dial for small integer
+// weights, radix heap for any other non-negative integers, 4-ary heap for floating point
+template<class W, long long MaxWeight>
+using DefaultPathQueue = conditional_t<!is_integral<W>::value, QuaternaryHeap<W>,
+                         conditional_t<(MaxWeight > 0 && MaxWeight <= 4096), DialQueue<W, MaxWeight>, RadixHeap<W>>>;
+
+// Single-source shortest paths into caller-owned buffers; queue storage is reused across
+// queries. run() refuses graphs the queue cannot handle (negative weights, or weights
+// above MaxWeight for Dial) and returns false.
+template<class W, long long MaxWeight = 0, class Queue = DefaultPathQueue<W, MaxWeight>>
+class ShortestPathEngine {
+    Queue queue;
+public:
+    static constexpr W UNREACHED = numeric_limits<W>::max();
+    static const char *queueName() { return Queue::name(); }
+
+    bool run(const CSRGraph<W> &g, int src, W *dist, int *parent) {
+        int n = g.size();
+        if (g.minWeight < 0) return false;
+        if (MaxWeight > 0 && is_integral<W>::value && g.maxWeight > (W)MaxWeight) return false;
+        fill(dist, dist + n, UNREACHED);
+        fill(parent, parent + n, -1);
+        if (src < 0 || src >= n) return true;
+        queue.reset(n);
+        dist[src] = 0;
+        queue.push(src, W(0));
+        int u;
+        W du;
+        while (queue.pop(u, du)) {
+            if (Queue::lazy && du != dist[u]) continue;   // superseded entry
+            for (int e = g.offset[u]; e < g.offset[u + 1]; e++) {
+                int v = g.to[e];
+                W nd = du + g.weight[e];
+                if (nd < dist[v]) {
+                    dist[v] = nd;
+                    parent[v] = u;
+                    queue.push(v, nd);
+                }
+            }
+        }
+        return true;
+    }
+};
+
+// City links are small integer travel costs
+using CityPathEngine = ShortestPathEngine<int, 255>;
+CSRGraph<int> cityCSR;
+
+vector<int> dijkstra(int src, int n) {
+    static CityPathEngine engine;
+    if (cityCSR.size() != (int)graphCity.size()) cityCSR = CSRGraph<int>::fromAdjacency(graphCity);
+    vector<int> dist(n), parent(n);
+    if (!engine.run(cityCSR, src, dist.data(), parent.data())) return dijkstraBinaryHeap(src, n);   // weight > 255
+    return dist;
+}
+
 /***************************************************************
                         BFS FOR FLOOD SPREAD
 ****************************************************************/
@@ -251,17 +1323,810 @@ void bfsFlood(int start, vector<vector<int>>& adj) {
 }
 
 /***************************************************************
-                        SORTING FUNCTIONS
+                 ZONE ENERGY RANKING (BUCKETED)
 ****************************************************************/
 
-void sortEnergy() {
-    sort(zones.begin(), zones.end(), [](Zone& a, Zone& b){
-        return a.energy > b.energy;
-    });
+// Zones ordered by energy (highest first, ties by id) without touching the master table.
+// Keys live in sorted blocks of 128-256 entries with a Fenwick tree over block
+// sizes: an update is two binary searches plus a short memmove inside a block, and
+// rank / k-th walk the Fenwick tree, all O(log n) with cache-friendly scans.
+class ZoneRanking {
+    static constexpr size_t BLOCK = 128;          // blocks split at 2 * BLOCK
+    vector<vector<uint64_t>> blocks;
+    vector<uint64_t> blockMax;
+    vector<int> fenwick;                          // 1-based, over block sizes
+    vector<int> energyOf;
+    size_t count = 0;
+
+    // Energy descending, then id ascending, as one unsigned key
+    static uint64_t key(int zone, int energy) {
+        uint32_t e = ~((uint32_t)energy ^ 0x80000000u);
+        return (uint64_t)e << 32 | (uint32_t)zone;
+    }
+    static int zoneOf(uint64_t k) { return (int)(uint32_t)k; }
+
+    void rebuildIndex() {
+        int b = blocks.size();
+        blockMax.resize(b);
+        fenwick.assign(b + 1, 0);
+        for (int i = 0; i < b; i++) {
+            blockMax[i] = blocks[i].back();
+            fenwick[i + 1] += blocks[i].size();
+            int j = (i + 1) + ((i + 1) & -(i + 1));
+            if (j <= b) fenwick[j] += fenwick[i + 1];
+        }
+    }
+    void fenwickAdd(int b, int delta) {
+        for (int i = b + 1; i < (int)fenwick.size(); i += i & -i) fenwick[i] += delta;
+    }
+    int blockFor(uint64_t k) const {
+        int b = lower_bound(blockMax.begin(), blockMax.end(), k) - blockMax.begin();
+        return min(b, (int)blocks.size() - 1);
+    }
+    void insertKey(uint64_t k) {
+        if (blocks.empty()) { blocks.push_back({k}); rebuildIndex(); count = 1; return; }
+        int b = blockFor(k);
+        auto &blk = blocks[b];
+        blk.insert(lower_bound(blk.begin(), blk.end(), k), k);
+        count++;
+        if (blk.size() >= 2 * BLOCK) {
+            vector<uint64_t> upper(blk.begin() + BLOCK, blk.end());
+            blk.resize(BLOCK);
+            blocks.insert(blocks.begin() + b + 1, move(upper));
+            rebuildIndex();
+            return;
+        }
+        blockMax[b] = blk.back();
+        fenwickAdd(b, 1);
+    }
+    void eraseKey(uint64_t k) {
+        int b = blockFor(k);
+        auto &blk = blocks[b];
+        auto it = lower_bound(blk.begin(), blk.end(), k);
+        if (it == blk.end() || *it != k) return;
+        blk.erase(it);
+        count--;
+        if (blk.empty()) { blocks.erase(blocks.begin() + b); rebuildIndex(); return; }
+        blockMax[b] = blk.back();
+        fenwickAdd(b, -1);
+    }
+
+public:
+    void build(const vector<Zone> &table) {
+        vector<uint64_t> keys(table.size());
+        energyOf.resize(table.size());
+        for (size_t i = 0; i < table.size(); i++) {
+            energyOf[i] = table[i].energy;
+            keys[i] = key(i, table[i].energy);
+        }
+        sort(keys.begin(), keys.end());
+        blocks.clear();
+        for (size_t i = 0; i < keys.size(); i += BLOCK)
+            blocks.emplace_back(keys.begin() + i, keys.begin() + min(keys.size(), i + BLOCK));
+        count = keys.size();
+        rebuildIndex();
+    }
+
+    void update(int zone, int energy) {
+        if (energyOf[zone] == energy) return;
+        eraseKey(key(zone, energyOf[zone]));
+        energyOf[zone] = energy;
+        insertKey(key(zone, energy));
+    }
+
+    int size() const { return count; }
+    int energy(int zone) const { return energyOf[zone]; }
+
+    // 0-based position of zone, 0 = highest energy
+    int rankOf(int zone) const {
+        uint64_t k = key(zone, energyOf[zone]);
+        int b = blockFor(k), r = 0;
+        for (int i = b; i > 0; i -= i & -i) r += fenwick[i];
+        return r + (lower_bound(blocks[b].begin(), blocks[b].end(), k) - blocks[b].begin());
+    }
+    // Zone at position k (0-based); k must be < size()
+    int zoneAt(int k) const {
+        int pos = 0, logB = 1;
+        while ((logB << 1) < (int)fenwick.size()) logB <<= 1;
+        for (int step = logB; step > 0; step >>= 1)
+            if (pos + step < (int)fenwick.size() && fenwick[pos + step] <= k) { pos += step; k -= fenwick[pos]; }
+        return zoneOf(blocks[pos][k]);
+    }
+    // The k highest-energy zones, in order
+    void topK(int k, vector<int> &out) const {
+        out.clear();
+        for (size_t b = 0; b < blocks.size() && (int)out.size() < k; b++)
+            for (size_t i = 0; i < blocks[b].size() && (int)out.size() < k; i++) out.push_back(zoneOf(blocks[b][i]));
+    }
+};
+
+ZoneRanking energyRanking;
+
+// Prints the top k zones by energy (k <= 0 prints all) straight from the ranking
+void printEnergyRanking(int k) {
+    int n = energyRanking.size();
+    if (k <= 0 || k > n) k = n;
+    vector<int> top;
+    energyRanking.topK(k, top);
+    cout << "\nZones ranked by energy usage:\n";
+    for (int i = 0; i < k; i++) {
+        const Zone &z = zones[top[i]];
+        cout << i + 1 << ". " << z.name << ": " << energyRanking.energy(z.id) << " units\n";
+    }
+}
+
+/***************************************************************
+                         BENCHMARKS
+****************************************************************/
+
+// Run with: ./city --bench [name] [size]   (no name = all)
+long long benchSize = 0;
+
+double secondsSince(chrono::steady_clock::time_point t0) {
+    return chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+}
+
+void makeRandomZones(int n, mt19937 &rng) {
+    zones.assign(n, Zone());
+    for (int i = 0; i < n; i++) {
+        zones[i].water = rng() % 5000;
+        zones[i].energy = rng() % 8000;
+        zones[i].waste = rng() % 300;
+        zones[i].pollution = rng() % 500;
+        zones[i].id = i;
+    }
+}
+
+// Random add/assign/scale/query mix against a plain double array, on awkward sizes. The
+// zone tree keeps float values, so answers only have to agree to float rounding.
+bool checkMetricTree(int n, int ops, mt19937 &rng) {
+    vector<array<double, METRIC_COUNT>> ref(n);
+    ZoneMetricTree t(n);
+    auto near = [](double got, double want, double scale) { return fabs(got - want) <= 1e-4 * (scale + 1); };
+    for (int i = 0; i < n; i++)
+        for (int m = 0; m < METRIC_COUNT; m++) ref[i][m] = rng() % 100;
+    t.build([&](int i, int m) { return ref[i][m]; });
+    for (int op = 0; op < ops; op++) {
+        int l = rng() % n, r = rng() % n;
+        if (l > r) swap(l, r);
+        if (rng() % 4 == 0) r = l;    // single zones take their own path
+        int m = rng() % METRIC_COUNT, kind = rng() % 4;
+        double v = (double)(rng() % 21) - 10;
+        if (kind == 0) { t.addRange(l, r, m, v); for (int i = l; i <= r; i++) ref[i][m] += v; }
+        else if (kind == 1) { t.assignRange(l, r, m, v); for (int i = l; i <= r; i++) ref[i][m] = v; }
+        else if (kind == 2) { t.scaleRange(l, r, m, v / 4); for (int i = l; i <= r; i++) ref[i][m] *= v / 4; }
+        else {
+            auto s = t.query(l, r);
+            for (int mm = 0; mm < METRIC_COUNT; mm++) {
+                double sum = 0, mass = 0, lo = 1e300, hi = -1e300;
+                for (int i = l; i <= r; i++) {
+                    sum += ref[i][mm];
+                    mass += fabs(ref[i][mm]);
+                    lo = min(lo, ref[i][mm]);
+                    hi = max(hi, ref[i][mm]);
+                }
+                if (!near(s.sum[mm], sum, mass) || !near(s.minv[mm], lo, fabs(lo)) || !near(s.maxv[mm], hi, fabs(hi)))
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
+void benchSegmentTree() {
+    const int N = benchSize > 0 ? (int)benchSize : 10000000, QUERIES = 1000000, POINT = 1000000;
+    mt19937 rng(1);
+    bool ok = checkMetricTree(1000, 20000, rng) && checkMetricTree(1237, 20000, rng) && checkMetricTree(1, 100, rng);
+
+    makeRandomZones(N, rng);
+    auto t0 = chrono::steady_clock::now();
+    segTree.assign(4 * N, 0);
+    buildST(1, 0, N - 1);
+    double recBuild = secondsSince(t0);
+    t0 = chrono::steady_clock::now();
+    buildZoneMetrics();
+    double itBuild = secondsSince(t0);
+
+    vector<pair<int, int>> ranges(QUERIES);
+    for (auto &q : ranges) {
+        q.first = rng() % N;
+        q.second = min(N - 1, q.first + (int)(rng() % (N / 10)));
+    }
+    // segTree holds int sums, which wrap past 2^31 on large ranges: compare modulo 2^32
+    auto sameWrapped = [](double sum, int rec) { return (uint32_t)(long long)sum == (uint32_t)rec; };
+    vector<int> recSums(QUERIES);
+    t0 = chrono::steady_clock::now();
+    for (int q = 0; q < QUERIES; q++) recSums[q] = queryST(1, 0, N - 1, ranges[q].first, ranges[q].second);
+    double recQuery = secondsSince(t0);
+    vector<double> itSums(QUERIES);
+    double allMetrics = 0;
+    t0 = chrono::steady_clock::now();
+    for (int q = 0; q < QUERIES; q++) {
+        auto s = zoneMetrics.query(ranges[q].first, ranges[q].second);
+        itSums[q] = s.sum[WATER];
+        allMetrics += s.sum[ENERGY] + s.maxv[POLLUTION] - s.minv[WASTE];
+    }
+    double itQuery = secondsSince(t0);
+    for (int q = 0; q < QUERIES; q++) ok = ok && sameWrapped(itSums[q], recSums[q]);
+
+    // Point updates: same new water values through both trees
+    vector<pair<int, int>> points(POINT);
+    for (auto &p : points) p = {(int)(rng() % N), (int)(rng() % 5000)};
+    t0 = chrono::steady_clock::now();
+    for (auto &p : points) updateST(1, 0, N - 1, p.first, p.second);
+    double recPoint = secondsSince(t0);
+    t0 = chrono::steady_clock::now();
+    for (auto &p : points) zoneMetrics.assignRange(p.first, p.first, WATER, p.second);
+    double itPoint = secondsSince(t0);
+    ok = ok && sameWrapped(zoneMetrics.query(0, N - 1).sum[WATER], queryST(1, 0, N - 1, 0, N - 1));
+
+    // Range add of up to 100k zones: n point updates for the recursive tree
+    const int REC_RANGES = 20, IT_RANGES = 1000000;
+    long long touched = 0;
+    t0 = chrono::steady_clock::now();
+    for (int i = 0; i < REC_RANGES; i++) {
+        int l = rng() % N, r = min(N - 1, l + (int)(rng() % 100000));
+        for (int p = l; p <= r; p++) updateST(1, 0, N - 1, p, (zones[p].water += 10));
+        touched += r - l + 1;
+    }
+    double recRange = secondsSince(t0) / REC_RANGES;
+    t0 = chrono::steady_clock::now();
+    for (int i = 0; i < IT_RANGES; i++) {
+        int l = rng() % N, r = min(N - 1, l + (int)(rng() % 100000));
+        zoneMetrics.addRange(l, r, (int)(rng() % METRIC_COUNT), 10);
+    }
+    double itRange = secondsSince(t0) / IT_RANGES;
+
+    cout << "Segment trees, " << N << " zones" << (ok ? "" : "  (MISMATCH)") << "\n"
+         << "  recursive (water only): build " << recBuild * 1e3 << " ms, range sum " << recQuery / QUERIES * 1e9
+         << " ns, point update " << recPoint / POINT * 1e9 << " ns, range +10 via point updates " << recRange * 1e3
+         << " ms (avg " << touched / REC_RANGES << " zones)\n"
+         << "  iterative lazy (4 metrics, sum/min/max): build " << itBuild * 1e3 << " ms, range query "
+         << itQuery / QUERIES * 1e9 << " ns, point assign " << itPoint / POINT * 1e9 << " ns, lazy range add "
+         << itRange * 1e9 << " ns, " << zoneMetrics.memoryBytes() / (1 << 20) << " MiB  (checksum "
+         << (long long)allMetrics % 1000 << ")\n";
+}
+
+// side x side 4-neighbour grid, weights uniform in [1, maxWeight]
+template<class W>
+vector<vector<pair<int, W>>> makeWeightedGrid(int side, W maxWeight, mt19937 &rng) {
+    vector<vector<pair<int, W>>> adj(side * side);
+    auto weight = [&]() -> W {
+        if (is_integral<W>::value) return (W)(1 + rng() % (long long)maxWeight);
+        return (W)(1.0 + (double)rng() / rng.max() * ((double)maxWeight - 1.0));
+    };
+    for (int r = 0; r < side; r++)
+        for (int c = 0; c < side; c++) {
+            int u = r * side + c;
+            if (c + 1 < side) { W w = weight(); adj[u].push_back({u + 1, w}); adj[u + 1].push_back({u, w}); }
+            if (r + 1 < side) { W w = weight(); adj[u].push_back({u + side, w}); adj[u + side].push_back({u, w}); }
+        }
+    return adj;
+}
+
+template<class Engine, class W>
+double timeEngine(Engine &engine, const CSRGraph<W> &g, const vector<int> &sources, vector<W> &dist,
+                  vector<int> &parent, const vector<W> &expect, bool &ok) {
+    auto t0 = chrono::steady_clock::now();
+    for (int s : sources) ok = engine.run(g, s, dist.data(), parent.data()) && ok;
+    double sec = secondsSince(t0) / sources.size();
+    ok = ok && dist == expect;   // distances of the last source
+    return sec;
+}
+
+template<long long MaxW>
+void benchIntegerWeights(int side, const vector<int> &sources, mt19937 &rng) {
+    graphCity = makeWeightedGrid<int>(side, (int)MaxW, rng);
+    CSRGraph<int> g = CSRGraph<int>::fromAdjacency(graphCity);
+    int n = side * side;
+    auto t0 = chrono::steady_clock::now();
+    vector<int> expect;
+    for (int s : sources) expect = dijkstraBinaryHeap(s, n);
+    double baseSec = secondsSince(t0) / sources.size();
+
+    vector<int> dist(n), parent(n);
+    bool ok = true;
+    // Above the Dial bound the default queue already is the radix heap: time it once
+    constexpr bool dial = is_same<DefaultPathQueue<int, MaxW>, DialQueue<int, MaxW>>::value;
+    ShortestPathEngine<int, MaxW> chosen;
+    ShortestPathEngine<int, MaxW, RadixHeap<int>> radix;
+    ShortestPathEngine<int, MaxW, QuaternaryHeap<int>> quad;
+    double chosenSec = timeEngine(chosen, g, sources, dist, parent, expect, ok);
+    double radixSec = dial ? timeEngine(radix, g, sources, dist, parent, expect, ok) : chosenSec;
+    double quadSec = timeEngine(quad, g, sources, dist, parent, expect, ok);
+    cout << "  int weights 1.." << setw(7) << left << MaxW << right << ": binary heap " << baseSec * 1e3 << " ms, ";
+    if (dial) cout << ShortestPathEngine<int, MaxW>::queueName() << " " << chosenSec * 1e3 << " ms, radix ";
+    else cout << "default (" << ShortestPathEngine<int, MaxW>::queueName() << ") ";
+    cout << radixSec * 1e3 << " ms, 4-ary " << quadSec * 1e3 << " ms" << (ok ? "" : "  (MISMATCH)") << "\n";
+}
+
+void benchShortestPaths() {
+    const int SIDE = benchSize > 0 ? (int)sqrt((double)benchSize) : 1000;
+    mt19937 rng(2);
+    vector<int> sources = {0, SIDE * SIDE / 2 + SIDE / 2, SIDE * SIDE - 1};
+    cout << "Shortest paths, " << SIDE << "x" << SIDE << " grid, " << sources.size() << " sources, ms per query\n";
+    benchIntegerWeights<1>(SIDE, sources, rng);
+    benchIntegerWeights<10>(SIDE, sources, rng);
+    benchIntegerWeights<255>(SIDE, sources, rng);
+    benchIntegerWeights<4096>(SIDE, sources, rng);
+    benchIntegerWeights<1000000>(SIDE, sources, rng);
+
+    // Floating-point weights: 4-ary heap against a lazy binary heap
+    auto adj = makeWeightedGrid<double>(SIDE, 1000.0, rng);
+    CSRGraph<double> g = CSRGraph<double>::fromAdjacency(adj);
+    int n = SIDE * SIDE;
+    vector<double> dist(n), expect(n, numeric_limits<double>::max());
+    vector<int> parent(n);
+    auto t0 = chrono::steady_clock::now();
+    for (int s : sources) {
+        fill(expect.begin(), expect.end(), numeric_limits<double>::max());
+        priority_queue<pair<double, int>, vector<pair<double, int>>, greater<pair<double, int>>> pq;
+        expect[s] = 0;
+        pq.push({0, s});
+        while (!pq.empty()) {
+            auto [d, u] = pq.top(); pq.pop();
+            if (d != expect[u]) continue;
+            for (auto &e : adj[u])
+                if (d + e.second < expect[e.first]) { expect[e.first] = d + e.second; pq.push({expect[e.first], e.first}); }
+        }
+    }
+    double baseSec = secondsSince(t0) / sources.size();
+    bool ok = true;
+    ShortestPathEngine<double> quad;
+    double quadSec = timeEngine(quad, g, sources, dist, parent, expect, ok);
+    cout << "  double weights 1..1000: binary heap " << baseSec * 1e3 << " ms, " << quad.queueName() << " "
+         << quadSec * 1e3 << " ms" << (ok ? "" : "  (MISMATCH)") << "\n";
+}
+
+// Random merge/split/query timeline checked against rebuilding a DSU from the live links
+bool checkOfflineConnectivity(int n, int events, mt19937 &rng) {
+    makeRandomZones(n, rng);
+    vector<ZoneMergeEvent> timeline;
+    vector<pair<int, int>> live;
+    vector<WhatIfAnswer> expect;
+    for (int i = 0; i < events; i++) {
+        int kind = rng() % 3;
+        if (kind == 1 && !live.empty()) {
+            int j = rng() % live.size();
+            pair<int, int> e = live[j];
+            timeline.push_back({MergeOp::Split, e.second, e.first});
+            // the solver closes the most recent merge of a pair; duplicates make that equivalent
+            live.erase(find(live.begin(), live.end(), e));
+        } else if (kind == 0) {
+            int a = rng() % n, b = rng() % n;
+            timeline.push_back({MergeOp::Merge, a, b});
+            live.push_back(minmax(a, b));
+        } else {
+            int a = rng() % n, b = rng() % n;
+            timeline.push_back({MergeOp::Query, a, b});
+            RollbackDSU fresh;
+            fresh.init(n);
+            for (int z = 0; z < n; z++) fresh.setTotals(z, zones[z].water, zones[z].energy);
+            for (auto &e : live) fresh.unite(e.first, e.second);
+            expect.push_back({fresh.connected(a, b), fresh.componentSize(a), fresh.componentWater(a), fresh.componentEnergy(a)});
+        }
+    }
+    initUF(n);
+    OfflineConnectivity solver;
+    auto got = solver.run(zoneUnion, timeline);
+    if (got.size() != expect.size() || zoneUnion.componentCount() != n) return false;
+    for (size_t i = 0; i < got.size(); i++)
+        if (got[i].connected != expect[i].connected || got[i].zones != expect[i].zones ||
+            got[i].water != expect[i].water || got[i].energy != expect[i].energy) return false;
+    return true;
+}
+
+void benchUnionFind() {
+    const int N = benchSize > 0 ? (int)benchSize : 1000000, BATCHES = 5000, PER_BATCH = 20, REBUILT = 200;
+    mt19937 rng(3);
+    bool ok = checkOfflineConnectivity(300, 3000, rng) && checkOfflineConnectivity(40, 5000, rng);
+
+    makeRandomZones(N, rng);
+    vector<pair<int, int>> base(N * 3 / 5);
+    for (auto &m : base) m = {int(rng() % N), int(rng() % N)};
+    vector<WhatIfBatch> batches(BATCHES);
+    for (auto &b : batches)
+        for (int i = 0; i < PER_BATCH; i++) {
+            b.merges.push_back({int(rng() % N), int(rng() % N)});
+            b.queries.push_back({int(rng() % N), int(rng() % N)});
+        }
+
+    // Baseline: rebuild the zone unions from scratch for every batch
+    auto t0 = chrono::steady_clock::now();
+    vector<WhatIfAnswer> expect;
+    for (int k = 0; k < REBUILT; k++) {
+        initUF(N);
+        for (auto &m : base) zoneUnion.unite(m.first, m.second);
+        auto one = evaluateWhatIfBatches(zoneUnion, {batches[k]});
+        expect.insert(expect.end(), one.begin(), one.end());
+    }
+    double rebuildSec = secondsSince(t0) / REBUILT;
+
+    initUF(N);
+    for (auto &m : base) zoneUnion.unite(m.first, m.second);
+    int before = zoneUnion.componentCount();
+    t0 = chrono::steady_clock::now();
+    auto got = evaluateWhatIfBatches(zoneUnion, batches);
+    double rollbackSec = secondsSince(t0) / BATCHES;
+    ok = ok && zoneUnion.componentCount() == before;
+    for (size_t i = 0; i < expect.size(); i++)
+        ok = ok && got[i].connected == expect[i].connected && got[i].water == expect[i].water && got[i].energy == expect[i].energy;
+
+    cout << "What-if merges, " << N << " zones, " << base.size() << " base merges, " << BATCHES << " batches of "
+         << PER_BATCH << " merges + " << PER_BATCH << " queries" << (ok ? "" : "  (MISMATCH)") << "\n";
+    cout << "  rebuild per batch: " << rebuildSec * 1e3 << " ms/batch\n";
+    cout << "  checkpoint/rollback: " << rollbackSec * 1e6 << " us/batch (" << rebuildSec / rollbackSec << "x)\n";
+
+    // One long timeline with splits, solved offline on top of the base unions
+    vector<ZoneMergeEvent> timeline;
+    vector<pair<int, int>> live;
+    for (int i = 0; i < N; i++) {
+        int kind = rng() % 3;
+        if (kind == 1 && !live.empty()) {
+            int j = rng() % live.size();
+            timeline.push_back({MergeOp::Split, live[j].first, live[j].second});
+            live[j] = live.back();
+            live.pop_back();
+        } else {
+            int a = rng() % N, b = rng() % N;
+            timeline.push_back({kind == 0 ? MergeOp::Merge : MergeOp::Query, a, b});
+            if (kind == 0) live.push_back({a, b});
+        }
+    }
+    t0 = chrono::steady_clock::now();
+    OfflineConnectivity solver;
+    auto answers = solver.run(zoneUnion, timeline);
+    double offlineSec = secondsSince(t0);
+    long long joined = count_if(answers.begin(), answers.end(), [](const WhatIfAnswer &a) { return a.connected; });
+    cout << "  offline timeline of " << timeline.size() << " merge/split/query events: " << offlineSec * 1e3 << " ms, "
+         << answers.size() << " queries (" << joined << " connected)"
+         << (zoneUnion.componentCount() == before ? "" : "  (STATE LEAKED)") << "\n";
+}
+
+void benchConcurrentUnionFind() {
+    const long long EDGES = benchSize > 0 ? benchSize : 50000000;
+    const int N = (int)max(1LL, EDGES / 5);
+    mt19937 rng(4);
+    // Sensor mesh: mostly neighbouring zones on a grid, a few long-range links
+    int side = max(1, (int)sqrt((double)N));
+    vector<pair<int, int>> edges(EDGES);
+    for (auto &e : edges) {
+        int a = rng() % N, r = rng() % 16, b;
+        if (r < 7) b = a + 1;
+        else if (r < 14) b = a + side;
+        else if (r < 15) b = a - 1;
+        else b = rng() % N;
+        e = {a, b < N && b >= 0 ? b : a};
+    }
+
+    // Baseline: sequential union by size with path compression
+    auto t0 = chrono::steady_clock::now();
+    vector<int> parent(N), sz(N, 1);
+    iota(parent.begin(), parent.end(), 0);
+    auto root = [&](int x) {
+        int r = x;
+        while (parent[r] != r) r = parent[r];
+        while (parent[x] != r) { int next = parent[x]; parent[x] = r; x = next; }
+        return r;
+    };
+    long long components = N;
+    for (auto &e : edges) {
+        int a = root(e.first), b = root(e.second);
+        if (a == b) continue;
+        if (sz[a] < sz[b]) swap(a, b);
+        parent[b] = a;
+        sz[a] += sz[b];
+        components--;
+    }
+    double seqSec = secondsSince(t0);
+
+    cout << "Concurrent union-find, " << N << " zones, " << EDGES << " edges, " << components << " components ("
+         << thread::hardware_concurrency() << " hw threads)\n";
+    cout << "  sequential path compression: " << seqSec * 1e3 << " ms\n";
+    for (int threads : {1, 2, 4, 8, 16, 32}) {
+        ConcurrentDSU dsu(N);
+        t0 = chrono::steady_clock::now();
+        long long joined = parallelUnite(dsu, edges, threads);
+        double sec = secondsSince(t0);
+        bool ok = N - joined == components;
+        for (int i = 0; i < 100000 && ok; i++) {
+            int a = rng() % N, b = rng() % N;
+            ok = dsu.connected(a, b) == (root(a) == root(b));
+        }
+        cout << "  lock-free, " << setw(2) << threads << " thread(s): " << sec * 1e3 << " ms ("
+             << EDGES / sec / 1e6 << " M edges/s)" << (ok ? "" : "  (MISMATCH)") << "\n";
+    }
+}
+
+// Random inserts/erases/queries against a sorted multiset of the same readings
+bool checkPollutionIndex(int ops, int maxValue, mt19937 &rng) {
+    PollutionIndex idx;
+    multiset<int> ref;
+    for (int op = 0; op < ops; op++) {
+        int kind = rng() % 4, v = rng() % (maxValue + 1);
+        long long c = 1 + rng() % 3;
+        if (kind == 0) { idx.insert(v, c); for (int i = 0; i < c; i++) ref.insert(v); }
+        else if (kind == 1) {
+            long long removed = idx.erase(v, c), expect = 0;
+            for (; expect < c && ref.find(v) != ref.end(); expect++) ref.erase(ref.find(v));
+            if (removed != expect) return false;
+        } else if (!ref.empty()) {
+            vector<int> sorted(ref.begin(), ref.end());
+            long long n = sorted.size(), k = rng() % n;
+            double p = rng() % 101;
+            long long rank = min(n - 1, max(0LL, (long long)ceil(p / 100.0 * n) - 1));
+            long long above = sorted.end() - upper_bound(sorted.begin(), sorted.end(), v);
+            long long top = accumulate(sorted.end() - (k + 1), sorted.end(), 0LL);
+            if (idx.size() != n || idx.kth(k) != sorted[k] || idx.percentile(p) != sorted[rank] ||
+                idx.countAbove(v) != above || idx.topSum(k + 1) != top) return false;
+        }
+    }
+    return true;
+}
+
+void benchPollutionIndex() {
+    const long long READINGS = benchSize > 0 ? benchSize : 100000000;
+    const int HOURS = 24, WINDOW = 6, QUERY_EVERY = 1000, MAX_VALUE = 999;
+    mt19937 rng(5);
+    bool ok = checkPollutionIndex(20000, 50, rng) && checkPollutionIndex(20000, 100000, rng);
+
+    // Readings skewed toward clean air, with a long tail
+    geometric_distribution<int> level(0.01);
+    auto reading = [&]() { return min(MAX_VALUE, level(rng)); };
+
+    // Baseline: the node-per-reading layout, as a std::multiset, on a slice of the day
+    const long long SLICE = min(READINGS, 5000000LL);
+    vector<int> slice(SLICE);
+    for (auto &v : slice) v = reading();
+    auto t0 = chrono::steady_clock::now();
+    {
+        multiset<int> perReading(slice.begin(), slice.end());
+        if ((long long)perReading.size() != SLICE) ok = false;
+    }
+    double multisetNs = secondsSince(t0) / SLICE * 1e9;
+    PollutionIndex sliceIdx;
+    t0 = chrono::steady_clock::now();
+    for (int v : slice) sliceIdx.insert(v);
+    double indexNs = secondsSince(t0) / SLICE * 1e9;
+
+    // A full day through the rolling window, checked against a value histogram
+    PollutionWindow window(WINDOW);
+    vector<vector<long long>> hourly;
+    vector<long long> live(MAX_VALUE + 1, 0);
+    long long perHour = READINGS / HOURS, queries = 0;
+    double checksum = 0;
+    t0 = chrono::steady_clock::now();
+    for (int h = 0; h < HOURS; h++) {
+        hourly.emplace_back(MAX_VALUE + 1, 0);
+        for (long long i = 0; i < perHour; i++) {
+            int v = reading();
+            window.record(v);
+            hourly.back()[v]++;
+            if (i % QUERY_EVERY == 0) {
+                const PollutionIndex &idx = window.index;
+                checksum += idx.percentile(95) + idx.median() + idx.countAbove(300) + idx.topMean(1000);
+                queries++;
+            }
+        }
+        window.advanceHour();
+        if ((int)hourly.size() > WINDOW - 1) hourly.erase(hourly.begin());
+    }
+    double daySec = secondsSince(t0);
+
+    // Exact answers from the histogram of the readings still in the window
+    fill(live.begin(), live.end(), 0);
+    for (auto &hist : hourly)
+        for (int v = 0; v <= MAX_VALUE; v++) live[v] += hist[v];
+    long long n = accumulate(live.begin(), live.end(), 0LL);
+    const PollutionIndex &idx = window.index;
+    ok = ok && idx.size() == n && checksum > 0;
+    for (double p : {1.0, 25.0, 50.0, 95.0, 99.9}) {
+        long long k = min(n - 1, max(0LL, (long long)ceil(p / 100.0 * n) - 1)), seen = 0;
+        int v = 0;
+        while (seen + live[v] <= k) seen += live[v++];
+        ok = ok && idx.percentile(p) == v;
+    }
 
-    cout << "\nZones sorted by energy usage:\n";
-    for (auto z : zones)
-        cout << z.name << ": " << z.energy << " units\n";
+    cout << "Pollution index, " << READINGS << " readings over " << HOURS << "h, " << WINDOW << "h window, "
+         << idx.distinct() << " distinct values" << (ok ? "" : "  (MISMATCH)") << "\n";
+    cout << "  insert, " << SLICE << " readings: multiset " << multisetNs << " ns/reading, index " << indexNs
+         << " ns/reading\n";
+    cout << "  full day with " << queries << " percentile/threshold/top-k query rounds: " << daySec << " s ("
+         << (perHour * HOURS) / daySec / 1e6 << " M readings/s), " << idx.memoryBytes() << " bytes of nodes"
+         << "\n";
+}
+
+// Random sets, compactions and historical queries against full copies of every hour
+bool checkPersistentTree(int n, int updates, mt19937 &rng) {
+    vector<double> live(n);
+    for (auto &v : live) v = rng() % 100;
+    PersistentSegmentTree<double> t;
+    t.build(n, [&](int i) { return live[i]; }, 0);
+    vector<vector<double>> hourly(1, live);   // state at the end of each hour
+    int perHour = updates / 10 + 1;
+    for (int u = 0; u < updates; u++) {
+        long long hour = u / perHour;
+        if (hour >= (long long)hourly.size()) hourly.push_back(live);
+        int i = rng() % n;
+        if (u % 8 == 0) {    // range edit: one version for the whole span
+            int j = min(n - 1, i + (int)(rng() % 50));
+            for (int k = i; k <= j; k++) live[k] = rng() % 100;
+            t.setRange(i, j, [&](int k) { return live[k]; }, hour);
+        } else {
+            live[i] = rng() % 100;
+            t.set(i, live[i], hour);
+        }
+        hourly.back() = live;
+        if (u % 997 == 0) t.compactBefore(hour, 1);
+        long long h = rng() % hourly.size();
+        int l = rng() % n, r = rng() % n;
+        if (l > r) swap(l, r);
+        double expect = accumulate(hourly[h].begin() + l, hourly[h].begin() + r + 1, 0.0);
+        if (t.query(t.versionAt(h), l, r) != expect) return false;
+    }
+    return true;
+}
+
+void benchPersistentTree() {
+    const long long UPDATES = benchSize > 0 ? benchSize : 10000000;
+    const int N = 1000000, HOURS = 24, QUERIES = 1000000;
+    mt19937 rng(6);
+    bool ok = checkPersistentTree(300, 5000, rng) && checkPersistentTree(1, 200, rng) && checkPersistentTree(1000, 20000, rng);
+
+    makeRandomZones(N, rng);
+    vector<double> live(N);
+    for (int i = 0; i < N; i++) live[i] = zones[i].water;
+    vector<double> hourTotal;                 // total water at the end of each hour
+    PersistentSegmentTree<double> t;
+    t.build(N, [&](int i) { return live[i]; }, 0);
+    double total = accumulate(live.begin(), live.end(), 0.0);
+    size_t baseNodes = t.nodeCount(), peakBytes = t.memoryBytes();
+    long long perHour = UPDATES / HOURS;
+    double compactSec = 0;
+
+    // A day of point updates; at each hour boundary, versions older than an hour are
+    // thinned to one per hour
+    auto t0 = chrono::steady_clock::now();
+    for (int h = 0; h < HOURS; h++) {
+        for (long long u = 0; u < perHour; u++) {
+            int i = rng() % N;
+            double v = rng() % 5000;
+            total += v - live[i];
+            live[i] = v;
+            t.set(i, v, h);
+        }
+        hourTotal.push_back(total);
+        peakBytes = max(peakBytes, t.memoryBytes());
+        auto c0 = chrono::steady_clock::now();
+        if (h > 0) t.compactBefore(h, 1);
+        compactSec += secondsSince(c0);
+    }
+    double updateSec = secondsSince(t0) - compactSec;
+    size_t nodesPerUpdate = 0;
+    {
+        size_t before = t.nodeCount();
+        t.set(0, live[0], HOURS - 1);
+        nodesPerUpdate = t.nodeCount() - before;
+    }
+
+    // Random range totals at random past hours
+    vector<int> ver(HOURS);
+    for (int h = 0; h < HOURS; h++) {
+        ver[h] = t.versionAt(h);
+        ok = ok && fabs(t.query(ver[h], 0, N - 1) - hourTotal[h]) < 1e-6 * hourTotal[h];
+    }
+    double checksum = 0;
+    t0 = chrono::steady_clock::now();
+    for (int q = 0; q < QUERIES; q++) {
+        int l = rng() % N, r = rng() % N;
+        if (l > r) swap(l, r);
+        checksum += t.query(ver[rng() % HOURS], l, r);
+    }
+    double querySec = secondsSince(t0) / QUERIES;
+    ok = ok && checksum > 0;
+
+    cout << "Persistent segment tree, " << N << " zones, " << perHour * HOURS << " updates over " << HOURS << "h"
+         << (ok ? "" : "  (MISMATCH)") << "\n";
+    cout << "  update: " << updateSec / (perHour * HOURS) * 1e9 << " ns, " << nodesPerUpdate << " nodes ("
+         << nodesPerUpdate * 16 << " bytes) per update\n";
+    cout << "  hourly compaction: " << compactSec * 1e3 << " ms total, peak " << peakBytes / (1 << 20) << " MiB, "
+         << t.versionCount() << " versions / " << t.memoryBytes() / (1 << 20) << " MiB kept (base tree "
+         << baseNodes * 16 / (1 << 20) << " MiB)\n";
+    cout << "  historical range query: " << querySec * 1e9 << " ns\n";
+}
+
+// Random updates with rank / k-th / top-k checked against a full sort
+bool checkZoneRanking(int n, int ops, mt19937 &rng) {
+    makeRandomZones(n, rng);
+    ZoneRanking r;
+    r.build(zones);
+    vector<int> energy(n), top;
+    for (int i = 0; i < n; i++) energy[i] = zones[i].energy;
+    for (int op = 0; op < ops; op++) {
+        int z = rng() % n, e = (int)(rng() % 50) - 10;   // narrow range: lots of ties
+        energy[z] = e;
+        r.update(z, e);
+        if (op % 50) continue;
+        vector<int> order(n);
+        iota(order.begin(), order.end(), 0);
+        sort(order.begin(), order.end(), [&](int a, int b) { return energy[a] != energy[b] ? energy[a] > energy[b] : a < b; });
+        int k = rng() % n;
+        r.topK(k, top);
+        if (r.size() != n || !equal(top.begin(), top.end(), order.begin())) return false;
+        for (int i = 0; i < n; i++)
+            if (r.zoneAt(i) != order[i] || r.rankOf(order[i]) != i) return false;
+    }
+    return true;
+}
+
+void benchZoneRanking() {
+    const int N = benchSize > 0 ? (int)benchSize : 1000000, UPDATES = 5000000, QUERY_EVERY = 1000;
+    mt19937 rng(7);
+    bool ok = checkZoneRanking(1, 200, rng) && checkZoneRanking(700, 20000, rng) && checkZoneRanking(3000, 5000, rng);
+
+    makeRandomZones(N, rng);
+    for (int i = 0; i < N; i++) zones[i].name = "Zone-" + to_string(i);
+    vector<pair<int, int>> updates(UPDATES);
+    for (auto &u : updates) u = {int(rng() % N), int(rng() % 8000)};
+
+    // Baseline 1: the old sortEnergy, copying and sorting the whole table per ranking
+    auto t0 = chrono::steady_clock::now();
+    vector<Zone> sorted = zones;
+    sort(sorted.begin(), sorted.end(), [](Zone &a, Zone &b) { return a.energy > b.energy; });
+    double fullSortSec = secondsSince(t0);
+
+    // Baseline 2: a node-based ordered set of (-energy, id)
+    set<pair<int, int>> ordered;
+    for (int i = 0; i < N; i++) ordered.insert({-zones[i].energy, i});
+    vector<int> setEnergy(N);
+    for (int i = 0; i < N; i++) setEnergy[i] = zones[i].energy;
+    t0 = chrono::steady_clock::now();
+    for (auto &u : updates) {
+        ordered.erase({-setEnergy[u.first], u.first});
+        setEnergy[u.first] = u.second;
+        ordered.insert({-u.second, u.first});
+    }
+    double setSec = secondsSince(t0);
+
+    ZoneRanking r;
+    t0 = chrono::steady_clock::now();
+    r.build(zones);
+    double buildSec = secondsSince(t0);
+    vector<int> top;
+    long long checksum = 0;
+    t0 = chrono::steady_clock::now();
+    for (int i = 0; i < UPDATES; i++) {
+        r.update(updates[i].first, updates[i].second);
+        if (i % QUERY_EVERY == 0) {
+            r.topK(10, top);
+            checksum += top[0] + r.rankOf(updates[i].first) + r.zoneAt(N / 2);
+        }
+    }
+    double rankSec = secondsSince(t0);
+    int pos = 0;
+    for (auto &p : ordered) ok = ok && r.zoneAt(pos++) == p.second;
+    ok = ok && checksum > 0;
+
+    cout << "Zone energy ranking, " << N << " zones, " << UPDATES << " updates, top-10/rank/k-th every "
+         << QUERY_EVERY << (ok ? "" : "  (MISMATCH)") << "\n";
+    cout << "  full copy + sort per ranking: " << fullSortSec * 1e3 << " ms\n";
+    cout << "  std::set update: " << setSec / UPDATES * 1e9 << " ns (" << UPDATES / setSec / 1e6 << " M/s)\n";
+    cout << "  bucketed ranking: build " << buildSec * 1e3 << " ms, update+queries " << rankSec / UPDATES * 1e9
+         << " ns (" << UPDATES / rankSec / 1e6 << " M/s)\n";
+}
+
+void runBenchmarks(const string &which) {
+    const vector<pair<string, function<void()>>> benches = {
+        {"segtree", benchSegmentTree},
+        {"sssp", benchShortestPaths},
+        {"dsu", benchUnionFind},
+        {"cdsu", benchConcurrentUnionFind},
+        {"pollution", benchPollutionIndex},
+        {"history", benchPersistentTree},
+        {"ranking", benchZoneRanking},
+    };
+    for (auto &b : benches)
+        if (which.empty() || which == b.first) b.second();
 }
 
 /***************************************************************
@@ -270,13 +2135,21 @@ void sortEnergy() {
 
 void showMenu() {
     cout << "\n================ CITY RESOURCE MANAGER ================\n";
-    cout << "1. Query total water usage (segment tree)\n";
+    cout << "1. Query zone metrics over a range (segment tree)\n";
     cout << "2. Shortest emergency path (Dijkstra)\n";
     cout << "3. Flood simulation (BFS)\n";
-    cout << "4. Sort zones by energy usage\n";
-    cout << "5. Insert pollution into AVL Tree\n";
+    cout << "4. Rank zones by energy usage\n";
+    cout << "5. Record a pollution reading\n";
     cout << "6. Connect zones (Union-Find)\n";
     cout << "7. Exit\n";
+    cout << "8. Adjust a metric over a range of zones\n";
+    cout << "9. What-if zone merges from a scenario file\n";
+    cout << "10. Bulk connect zone pairs from a file (parallel Union-Find)\n";
+    cout << "11. Pollution statistics (percentiles, threshold, top-k)\n";
+    cout << "12. Advance the city clock one hour\n";
+    cout << "13. Historical metric total over a range at a past hour\n";
+    cout << "14. Compact metric history older than a given hour\n";
+    cout << "15. Update a zone's energy usage\n";
     cout << "=======================================================\n";
 }
 
@@ -284,13 +2157,18 @@ void showMenu() {
                             MAIN
 ****************************************************************/
 
-int main() {
+int main(int argc, char **argv) {
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        if (argc > 3) benchSize = atoll(argv[3]);
+        runBenchmarks(argc > 2 ? argv[2] : "");
+        return 0;
+    }
+
     int n;
     cout << "Enter number of zones: ";
     cin >> n;
 
     zones.resize(n);
-    segTree.resize(4*n);
     graphCity.resize(n);
 
     cout << "\nEnter zone data:\n";
@@ -311,16 +2189,21 @@ int main() {
     }
 
     // Build segment tree
-    buildST(1, 0, n-1);
+    buildZoneMetrics();
+    energyRanking.build(zones);
 
     // Simple connected graph
     for (int i = 0; i < n-1; i++) {
         graphCity[i].push_back({i+1, 5});
         graphCity[i+1].push_back({i, 5});
     }
+    cityCSR = CSRGraph<int>::fromAdjacency(graphCity);
 
     initUF(n);
-    AVL* pollutionTree = NULL;
+    long long cityHour = 0;
+    buildZoneHistory(cityHour);
+    PollutionWindow pollution(24);
+    for (auto &z : zones) pollution.record(z.pollution);
 
     while (true) {
         showMenu();
@@ -331,7 +2214,9 @@ int main() {
             int l, r;
             cout << "Range (l r): ";
             cin >> l >> r;
-            cout << "Total water = " << queryST(1, 0, n-1, l, r) << " L\n";
+            auto s = zoneMetrics.query(l, r);
+            for (int m = 0; m < METRIC_COUNT; m++)
+                cout << metricNames[m] << ": total " << s.sum[m] << ", min " << s.minv[m] << ", max " << s.maxv[m] << "\n";
         }
 
         else if (ch == 2) {
@@ -354,15 +2239,19 @@ int main() {
         }
 
         else if (ch == 4) {
-            sortEnergy();
+            int k;
+            cout << "How many zones (0 = all): ";
+            cin >> k;
+            printEnergyRanking(k);
         }
 
         else if (ch == 5) {
             int p;
             cout << "Enter pollution value to insert: ";
             cin >> p;
-            pollutionTree = insertAVL(pollutionTree, p);
-            cout << "Inserted.\n";
+            pollution.record(p);
+            cout << "Inserted (" << pollution.index.size() << " readings in the last "
+                 << pollution.windowHours() << " hours).\n";
         }
 
         else if (ch == 6) {
@@ -370,7 +2259,115 @@ int main() {
             cout << "Connect zone A and B: ";
             cin >> a >> b;
             unionUF(a, b);
-            cout << "Connected. Root of A = " << findUF(a) << "\n";
+            cout << "Connected. Root of A = " << findUF(a) << " (" << zoneUnion.componentSize(a) << " zones, water "
+                 << zoneUnion.componentWater(a) << ", energy " << zoneUnion.componentEnergy(a) << ")\n";
+        }
+
+        else if (ch == 8) {
+            int l, r, m;
+            char op;
+            double v;
+            cout << "Range (l r), metric (0 water, 1 energy, 2 waste, 3 pollution), op (+ add, = set, % change) and value: ";
+            cin >> l >> r >> m >> op >> v;
+            if (m < 0 || m >= METRIC_COUNT) { cout << "Unknown metric.\n"; continue; }
+            if (op == '+') zoneMetrics.addRange(l, r, m, v);
+            else if (op == '=') zoneMetrics.assignRange(l, r, m, v);
+            else if (op == '%') zoneMetrics.scaleRange(l, r, m, 1.0 + v / 100.0);
+            else { cout << "Unknown op.\n"; continue; }
+            for (int i = max(l, 0); i <= min(r, n - 1); i++) {
+                syncZoneMetric(i, m);
+                if (m == ENERGY) energyRanking.update(i, zones[i].energy);
+            }
+            recordZoneHistory(l, r, m, cityHour);
+            cout << "Updated " << metricNames[m] << " for zones " << l << ".." << r << ".\n";
+        }
+
+        else if (ch == 9) {
+            string path;
+            cout << "Scenario file (e.g. datasets/case23_zone_merges.csv): ";
+            cin >> path;
+            vector<ZoneMergeEvent> events;
+            if (!loadZoneMerges(path, events)) { cout << "Cannot read " << path << ".\n"; continue; }
+            vector<pair<int, int>> asked;
+            for (auto &ev : events)
+                if (ev.op == MergeOp::Query && ev.a >= 0 && ev.b >= 0 && ev.a < n && ev.b < n) asked.push_back({ev.a, ev.b});
+            OfflineConnectivity solver;
+            auto answers = solver.run(zoneUnion, events);
+            for (size_t i = 0; i < answers.size(); i++)
+                cout << "Zones " << asked[i].first << " and " << asked[i].second << ": "
+                     << (answers[i].connected ? "connected" : "separate") << "; zone " << asked[i].first << "'s group has "
+                     << answers[i].zones << " zones, water " << answers[i].water << ", energy " << answers[i].energy << "\n";
+            cout << answers.size() << " queries answered; current connections unchanged.\n";
+        }
+
+        else if (ch == 10) {
+            string path, line;
+            cout << "Pairs file (one \"zone_a,zone_b\" per line): ";
+            cin >> path;
+            ifstream in(path);
+            if (!in) { cout << "Cannot read " << path << ".\n"; continue; }
+            vector<pair<int, int>> edges;
+            while (getline(in, line)) {
+                int a, b;
+                if (sscanf(line.c_str(), "%d,%d", &a, &b) == 2) edges.push_back({a, b});
+            }
+            long long joined = bulkConnectZones(edges);
+            cout << edges.size() << " pairs read, " << joined << " new connections, " << zoneUnion.componentCount()
+                 << " groups now.\n";
+        }
+
+        else if (ch == 11) {
+            const PollutionIndex &idx = pollution.index;
+            if (idx.size() == 0) { cout << "No readings.\n"; continue; }
+            double p;
+            int threshold;
+            long long k;
+            cout << "Percentile, threshold and k: ";
+            cin >> p >> threshold >> k;
+            cout << idx.size() << " readings, mean " << (double)idx.total() / idx.size() << ", median " << idx.median()
+                 << "\n" << p << "th percentile: " << idx.percentile(p) << "\n"
+                 << "Above " << threshold << ": " << idx.countAbove(threshold) << "\n"
+                 << "Mean of top " << min(k, idx.size()) << ": " << idx.topMean(k) << "\n";
+        }
+
+        else if (ch == 12) {
+            pollution.advanceHour();
+            cityHour++;
+            cout << "Hour " << cityHour << ": " << pollution.index.size() << " pollution readings remain in the window.\n";
+        }
+
+        else if (ch == 13) {
+            long long hour;
+            int l, r, m;
+            cout << "Hour, range (l r) and metric (0 water, 1 energy, 2 waste, 3 pollution): ";
+            cin >> hour >> l >> r >> m;
+            if (m < 0 || m >= METRIC_COUNT) { cout << "Unknown metric.\n"; continue; }
+            int ver = zoneHistory[m].versionAt(hour);
+            if (ver < 0) { cout << "No history that far back.\n"; continue; }
+            cout << "Total " << metricNames[m] << " for zones " << l << ".." << r << " at hour " << hour << ": "
+                 << zoneHistory[m].query(ver, l, r) << " (version " << ver << " of " << zoneHistory[m].versionCount() << ")\n";
+        }
+
+        else if (ch == 14) {
+            long long cutoff, every;
+            cout << "Compact versions before hour, keeping one per how many hours: ";
+            cin >> cutoff >> every;
+            if (every < 1) every = 1;
+            size_t released = 0;
+            for (auto &h : zoneHistory) released += h.compactBefore(cutoff, every);
+            cout << released << " history nodes released.\n";
+        }
+
+        else if (ch == 15) {
+            int z, e;
+            cout << "Zone ID and new energy usage: ";
+            cin >> z >> e;
+            if (z < 0 || z >= n) { cout << "Unknown zone.\n"; continue; }
+            zoneMetrics.assignRange(z, z, ENERGY, e);
+            syncZoneMetric(z, ENERGY);
+            recordZoneHistory(z, z, ENERGY, cityHour);
+            energyRanking.update(z, e);
+            cout << zones[z].name << " is now #" << energyRanking.rankOf(z) + 1 << " of " << n << " by energy.\n";
         }
 
         else if (ch == 7) {